@@ -36,10 +36,100 @@ const wss = new WebSocket.Server({ server, path: '/ws' });
 
 // 存储连接的客户端
 const clients = {
-  cpp: null,      // C++ 客户端 (bridge)
+  workers: new Map(),   // C++ 客户端 (bridge)，按 worker 编号，单进程运行时为 'default'
   frontends: new Set()  // 前端连接集合
 };
 
+// 延迟直方图分段的中点 (微秒)，与 client/src/scoreboard.h 中 LatencyHistogram 的分段一致
+const LATENCY_SUB = 8;
+function bucketMiddle(b) {
+  if (b < LATENCY_SUB) return b;
+  const width = 2 ** (Math.floor(b / LATENCY_SUB) - 1);
+  return (LATENCY_SUB + b % LATENCY_SUB) * width + width / 2;
+}
+
+// 分位数 q，单位毫秒；buckets 为按编号排列的 [编号, 个数]
+function latencyQuantile(buckets, total, q) {
+  let rank = Math.max(1, Math.floor(q * total + 0.999999));
+  for (const [b, count] of buckets) {
+    rank -= count;
+    if (rank <= 0) return bucketMiddle(b) / 1000;
+  }
+  return 0;
+}
+
+// 分片比赛的汇总：保存每个分片最新的累计成绩 (partial)，合并成一份 rank_update
+// 各项累计值直接相加；评分按精度 (1 / RD²) 加权，扣除各分片重复计入的初始先验
+const RATING_PRIOR = { rating: 1500, rd: 350 };
+const shardResults = {
+  seed: null,
+  partials: new Map(),  // shard -> 最新的 partial 消息
+
+  // 新的一场比赛 (种子变化) 时清空
+  begin(seed) {
+    if (seed !== this.seed) {
+      this.seed = seed;
+      this.partials.clear();
+    }
+  },
+
+  update(message) {
+    this.partials.set(message.shard, message);
+    const players = new Map();
+    let gamesDone = 0;
+    for (const partial of this.partials.values()) {
+      gamesDone += partial.games_done;
+      for (const p of partial.data) {
+        let sum = players.get(p.name);
+        if (!sum) {
+          sum = {
+            name: p.name, exe: p.exe, score: 0, deal_score: 0, wins: 0, forfeits: 0, timeouts: 0,
+            decisions: 0, cpu_ms: 0, peak_rss_kb: 0, endgame_decisions: 0, endgame_blunders: 0, precision: 0, weighted: 0, shards: 0, latency: new Map()
+          };
+          players.set(p.name, sum);
+        }
+        for (const key of ['score', 'wins', 'forfeits', 'timeouts', 'decisions', 'cpu_ms', 'endgame_decisions', 'endgame_blunders']) {
+          sum[key] += p[key] || 0;
+        }
+        sum.peak_rss_kb = Math.max(sum.peak_rss_kb, p.peak_rss_kb);
+        const precision = 1 / (p.rating_rd * p.rating_rd);
+        sum.precision += precision;
+        sum.weighted += precision * p.rating;
+        sum.shards++;
+        for (const [b, count] of p.latency) sum.latency.set(b, (sum.latency.get(b) || 0) + count);
+        if (partial === message) sum.deal_score = p.deal_score;
+      }
+    }
+
+    const priorPrecision = 1 / (RATING_PRIOR.rd * RATING_PRIOR.rd);
+    const data = [...players.values()].map(sum => {
+      const extra = (sum.shards - 1) * priorPrecision;
+      const precision = Math.max(sum.precision - extra, priorPrecision);
+      const rating = (sum.weighted - extra * RATING_PRIOR.rating) / precision;
+      const buckets = [...sum.latency.entries()].sort((a, b) => a[0] - b[0]);
+      return {
+        name: sum.name, exe: sum.exe, score: sum.score, deal_score: sum.deal_score, wins: sum.wins,
+        forfeits: sum.forfeits, timeouts: sum.timeouts, decisions: sum.decisions,
+        p50_ms: latencyQuantile(buckets, sum.decisions, 0.5),
+        p99_ms: latencyQuantile(buckets, sum.decisions, 0.99),
+        cpu_ms: sum.cpu_ms, peak_rss_kb: sum.peak_rss_kb,
+        endgame_decisions: sum.endgame_decisions, endgame_blunders: sum.endgame_blunders,
+        rating: Math.round(rating), rating_ci: Math.round(1.96 / Math.sqrt(precision))
+      };
+    });
+    const key = message.rank_by === 'rating' ? 'rating' : 'score';
+    data.sort((a, b) => b[key] - a[key]);
+    data.forEach((p, i) => { p.rank = i + 1; });
+    return {
+      type: 'rank_update',
+      game_num: gamesDone - 1,
+      total_games: message.total_games,
+      shards: this.partials.size,
+      data
+    };
+  }
+};
+
 // 中间件
 app.use(express.json());
 
@@ -48,7 +138,8 @@ app.get('/api/health', (req, res) => {
   res.json({
     status: 'ok',
     connections: {
-      cpp: clients.cpp ? 'connected' : 'disconnected',
+      cpp: clients.workers.size ? 'connected' : 'disconnected',
+      workers: clients.workers.size,
       frontends: clients.frontends.size
     },
     timestamp: new Date().toISOString()
@@ -58,7 +149,8 @@ app.get('/api/health', (req, res) => {
 // 获取当前游戏状态 API
 app.get('/api/status', (req, res) => {
   res.json({
-    cppConnected: !!clients.cpp,
+    cppConnected: clients.workers.size > 0,
+    workerCount: clients.workers.size,
     frontendCount: clients.frontends.size
   });
 });
@@ -70,39 +162,43 @@ wss.on('connection', (ws, req) => {
   console.log(`[${new Date().toLocaleTimeString()}] 新连接: ${clientType}`);
 
   if (clientType === 'cpp') {
-    // C++ 客户端连接
-    if (clients.cpp) {
-      console.log('⚠️  已有 C++ 客户端连接,关闭旧连接');
-      clients.cpp.close();
+    // C++ 客户端连接，分片运行时每个 worker 一个连接 (?type=cpp&worker=<分片编号>)
+    const worker = new URL(req.url, 'ws://localhost').searchParams.get('worker') || 'default';
+    if (clients.workers.has(worker)) {
+      console.log(`⚠️  worker ${worker} 已有连接,关闭旧连接`);
+      clients.workers.get(worker).close();
     }
     
-    clients.cpp = ws;
-    console.log('✅ C++ 客户端已连接');
+    clients.workers.set(worker, ws);
+    console.log(`✅ C++ 客户端已连接 (worker ${worker}, 共 ${clients.workers.size} 个)`);
     
     // 通知所有前端
     broadcastToFrontends({
       type: 'sys_log',
-      message: 'C++ 客户端已连接'
+      message: `C++ 客户端已连接 (worker ${worker})`
     });
 
     ws.on('message', (data) => {
       try {
         const message = JSON.parse(data.toString());
-        console.log(`[CPP → Server] 收到数据类型: ${message.type}`);
+        console.log(`[CPP ${worker} → Server] 收到数据类型: ${message.type}`);
         
-        // 转发给所有前端
-        broadcastToFrontends(message);
+        if (message.type === 'init' && message.shards > 1) shardResults.begin(message.seed);
+        // 分片的累计成绩合并后再转发，其余消息直接转发给所有前端
+        if (message.type === 'partial') broadcastToFrontends(shardResults.update(message));
+        else broadcastToFrontends(message);
       } catch (e) {
         console.error('解析 C++ 消息失败:', e);
       }
     });
 
     ws.on('close', () => {
-      console.log('❌ C++ 客户端断开连接');
-      clients.cpp = null;
+      console.log(`❌ C++ 客户端断开连接 (worker ${worker})`);
+      // 已经打完的分片的成绩仍然保留在汇总中
+      if (clients.workers.get(worker) === ws) clients.workers.delete(worker);
       broadcastToFrontends({
         type: 'sys_log',
-        message: 'C++ 客户端已断开'
+        message: `C++ 客户端已断开 (worker ${worker})`
       });
     });
 
@@ -118,7 +214,7 @@ wss.on('connection', (ws, req) => {
     }));
 
     // 如果 C++ 已连接,通知前端
-    if (clients.cpp) {
+    if (clients.workers.size > 0) {
       ws.send(JSON.stringify({
         type: 'sys_log',
         message: 'C++ 客户端在线'
@@ -131,9 +227,9 @@ wss.on('connection', (ws, req) => {
         console.log(`[Frontend → Server] 收到消息:`, message);
         
         // 可以添加前端到 C++ 的通信逻辑
-        if (clients.cpp && clients.cpp.readyState === WebSocket.OPEN) {
-          clients.cpp.send(JSON.stringify(message));
-        }
+        clients.workers.forEach(cpp => {
+          if (cpp.readyState === WebSocket.OPEN) cpp.send(JSON.stringify(message));
+        });
       } catch (e) {
         console.error('解析前端消息失败:', e);
       }
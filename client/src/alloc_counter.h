@@ -0,0 +1,31 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+// 统计堆分配次数 (基准测试用)：替换全局的 operator new/delete，每次分配计数一次。
+// 替换全局分配函数的定义在一个程序里只能出现一次，只能由一个源文件包含。
+// new[] 和 nothrow 版本默认转发到这里；按对齐分配 (alignas 超过 16 的类型) 不计入。
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<long long> allocation_count{0};
+
+void* operator new(std::size_t n) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// GCC 把 new 出来的指针交给 free 视为不匹配，这里正是替换后的配对
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // ALLOC_COUNTER_H
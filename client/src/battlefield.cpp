@@ -16,8 +16,32 @@
 #include <iomanip>
 #include <cstring>
 #include <filesystem>
-#include "jsoncpp/json.h"
+#include <deque>
+#include <mutex>
+#include <functional>
+#include <atomic>
+#include <thread>
 #include "yaml_parser.h"
+#include "bot_process.h"
+#include "cards.h"
+#include "table.h"
+#include "scheduler.h"
+#include "scoreboard.h"
+#include "pool.h"
+#include "replay.h"
+#include "plugin.h"
+#include "cache.h"
+#include "reference_bot.h"
+#include "rating.h"
+#include "checkpoint.h"
+#include "prespawn.h"
+#include "deal_bank.h"
+#include "trace.h"
+#include "uplink.h"
+#include "endgame.h"
+#ifdef BATTLEFIELD_COUNT_ALLOCS
+#include "alloc_counter.h"
+#endif
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -33,20 +57,90 @@ int TOTAL_GAMES = 20;
 int PLAYER_NUMBER = 12;
 string BOT_DIR = "bots";
 string DEFAULT_BOT = "demo";
-vector<pair<string, string>> bots;
+vector<pair<string, string>> bots;  // (exe, 玩家名)，下标即玩家 id，加载后不再改变顺序
+vector<const bf_plugin*> plugins;   // 按玩家 id，进程内插件 (bot_dir 下的 .so/.dll)，可执行文件为 nullptr
+// 长时运行模式: off 每次决策启动一次进程; game 每局每个座位启动一次; tournament 每个玩家整个比赛只启动一次
+string KEEP_RUNNING = "off";
+set<string> keep_running_bots;  // 支持长时运行的 bot (文件名，不带后缀)，为空表示全部
+vector<BotProcess> bot_processes;  // tournament 模式下按玩家 id 保存的常驻进程
+// 调度方式: omp 每桌占用一个线程阻塞等待; epoll 单线程事件循环同时驱动所有桌 (仅 POSIX)
+string SCHEDULER = "omp";
+int MAX_INFLIGHT_TABLES = 0;  // epoll 调度时同时进行的桌数上限，0 表示不限制
+string BOT_INPUT = "argv";  // 单次启动时输入的传递方式: argv 作为唯一的命令行参数; stdin 写入标准输入
+int PRESPAWN = 0;  // bot_input: stdin 时每个可执行文件预先启动的空闲进程数，0 表示不预先启动
+PrespawnPool prespawn_pool;
+Limits LIMITS;  // 每次叫分/出牌的墙钟时间和 CPU 时间限制 (毫秒)，0 表示不限制
+// 发牌方式: single 每桌每轮打一局; duplicate 同一副牌由同桌三人按全部 6 种座位排列各打一局，
+// 每人都拿过每一手牌、坐过每个位置，牌运在一桌之内相互抵消
+string DEAL_MODE = "single";
+// 牌库文件，第 r 轮用其中第 r 副牌 (座位仍由种子决定)，为空表示每轮按种子洗牌
+string DEAL_BANK = "";
+DealBank deal_bank;
+// 各轮不再逐轮同步：所有轮次的桌都是独立任务，同时进行的轮数上限，0 表示按线程数自动选择
+int MAX_INFLIGHT_ROUNDS = 0;
+// on: 每个 bot 同一时间只打一局 (按轮次顺序)；keep_running: tournament 时常驻进程只能服务一桌，总是 on
+string ONE_GAME_PER_BOT = "off";
+string REPLAY_DIR = "";  // 对局记录目录，每个工作线程写一个 worker<n>.bfr，为空表示不记录
+vector<ReplayWriter> replays;  // 按工作线程编号
+set<string> deterministic_bots;  // 声明为确定性的 bot (文件名，不带后缀)，它们单次启动时的输出可以缓存
+int DECISION_CACHE_SIZE = 65536; // 决策缓存的条目数上限
+DecisionCache decision_cache;
+vector<uint64_t> cache_seed;     // 按玩家 id，bot 路径的哈希；0 表示不缓存
+// 排座方式: random 每轮随机; adaptive 按评分安排，让每一轮尽量多地减小评分的不确定性 (排名也改按评分)
+string MATCHMAKING = "random";
+int EARLY_STOP_TOP_K = 0;            // 前 k 名的顺序确定后提前结束比赛，0 表示不提前结束
+int EARLY_STOP_CONFIDENCE = 95;      // 判断顺序确定的置信水平 (百分比)
+int EARLY_STOP_MIN_GAMES = 10;       // 至少打完的轮数
+Ratings ratings;
+// 分片: 一场比赛由多个进程分担，本进程只打第 r 轮中 r % SHARD_COUNT == SHARD_ID 的轮次，
+// 输出可以合并的累计成绩 (partial)，由后端汇总成一份排名
+int SHARD_ID = 0;
+int SHARD_COUNT = 1;
+uint64_t SEED = 0;  // 基础种子，第 r 轮的发牌和座位只由 (SEED, r) 决定，各分片一致
+bool SEED_GIVEN = false;  // 种子由配置或命令行指定；否则续打时沿用检查点里的种子
+int ONLY_GAME = -1;       // --game r: 只打第 r 轮 (单独重现一轮)，-1 表示正常比赛
+// 检查点文件，每打完 CHECKPOINT_INTERVAL 轮 (和全部打完时) 写入一次，为空表示不写；
+// 启动时文件已存在则从中恢复成绩和已打完的轮次，只打剩下的轮次
+string CHECKPOINT_FILE = "";
+int CHECKPOINT_INTERVAL = 100;
+RoundSet completed_rounds;  // 已合并进总成绩的轮次
 
-struct node {
-    vector<int> score, round;
-    void init(int size) {
-        score.resize(size, 0);
-        round.resize(size, 0);
-    }
-};
-map<string,node> Final_score;
-map<string,int> player_winning_rounds, player_winning_scores;
-std::mt19937_64 rng(time(0));
+// 分阶段耗时追踪，导出为 Chrome trace JSON，为空表示不追踪
+string TRACE_FILE = "";
+int TRACE_BUFFER = 262144;  // 每个线程保留的最近事件数
+
+// 残局分析：每局打完后，从每家都不超过 ENDGAME_CARDS 张起逐个局面明牌求解，统计各 bot 把必胜局面走成必败的次数；
+// 0 表示不分析。每个局面最多搜索 ENDGAME_NODE_LIMIT 个节点，超出的局面不计入
+int ENDGAME_CARDS = 0;
+int ENDGAME_NODE_LIMIT = 200000;
+
+// 叫分的推测执行：这些 bot 声明为没有副作用 (文件名，不带后缀)，单次启动时座位 0 一开始叫分，
+// 就按前面座位所有可能的叫分 (每家 0..3) 提前启动座位 1、2 的叫分决策，实际叫分确定后接管对应的进程，其余结束
+set<string> speculative_bots;
+int SPECULATION_BUDGET = 0;  // 所有桌同时进行的推测进程数上限，0 表示按 CPU 核数
+vector<char> speculative;    // 按玩家 id，叫分时可以推测执行
+atomic<int> speculation_running{0};
+atomic<long long> speculation_launched{0}, speculation_used{0}, speculation_cancelled{0};
 
-constexpr short card2level(short card){return card/4 + card/53;}
+// 排名等消息的上行方式: stdout 以 JSON_DATA: 行输出，由 bridge 转发; websocket 引擎直接连接 backend_url
+string UPLINK = "stdout";
+string BACKEND_URL = "ws://localhost:3126/ws?type=cpp";
+int UPLINK_INTERVAL_MS = 100;  // websocket 上行的发送间隔，间隔内的多次排名只发最新的一次
+Uplink uplink;
+
+Scoreboard scoreboard;
+
+// 每轮的随机数分成互相独立的几路，改变排座方式不影响发牌
+enum RoundStream { DEAL_STREAM = 0, SEATING_STREAM = 1 };
+
+// 第 game_no 轮某一路的随机数发生器 (splitmix64 打散种子)
+std::mt19937_64 round_rng(int game_no, RoundStream stream)
+{
+	uint64_t z = SEED + 0x9e3779b97f4a7c15ULL * (uint64_t)(2 * game_no + stream + 1);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return std::mt19937_64(z ^ (z >> 31));
+}
 
 template <class T>
 void print_vector(vector<T> vec)
@@ -55,10 +149,9 @@ void print_vector(vector<T> vec)
 	cout << endl;
 }
 
-template <class T>
-void print_set(set<T> set)
+void print_set(CardSet set)
 {
-	for (T c : set)
+	for (short c : set)
 	{
 		int j = card2level(c) + 3;
 		if (j == 14)j = 1;
@@ -70,30 +163,359 @@ void print_set(set<T> set)
 	cout << endl;
 }
 
-string get_response(const char* cmd)
+// 单次启动模式：启动 bot 并交给它完整输入，失败时返回 false
+bool spawn_once(int id, const Transcript& t, BotProcess& proc)
 {
-	char result[2048] = "";
-	char buf_ps[2048];
-	char ps[2048] = {};
-	FILE* ptr;
+	const auto& bot = bots[id];
+	bool by_argv = BOT_INPUT == "argv";
+	// 预先启动的进程从写入输入时开始计时
+	if (!by_argv && prespawn_pool.acquire(id, proc)) proc.begin_decision();
+	else
+	{
+		proc.begin_decision();
+		if (!proc.start(bot.first, by_argv ? t.input().data() : nullptr))
+		{
+			cerr << "Error: cannot start bot " << bot.first << endl;
+			return false;
+		}
+	}
+	if (!by_argv) proc.send_line(t.input());
+	proc.close_input();
+	return true;
+}
 
-	strcpy(ps, cmd);  // 如编译不通过的话将strcpy_s改成strcpy
-#ifdef _WIN32
-	for (int i = 0; ps[i] != 0; ++i) {
-		if (ps[i] == '/') {
-			ps[i] = '\\';
+bool keep_running_enabled(int id)
+{
+	if (KEEP_RUNNING == "off") return false;
+	return keep_running_bots.empty() || keep_running_bots.count(fs::path(bots[id].first).stem().string());
+}
+
+// 长时运行模式：取得 bot 的常驻进程并写入本次输入，失败时返回 nullptr
+// t 为该座位本局到目前为止的交互记录 (已包含本次请求)
+BotProcess* send_to_resident(int id, const Transcript& t, BotProcess& local)
+{
+	const auto& bot = bots[id];
+	BotProcess& proc = KEEP_RUNNING == "tournament" ? bot_processes[id] : local;
+	// 每局第一次决策 (或进程重启后) 发送完整输入，bot 据此重置状态
+	bool fresh = t.requests() == 1;
+	proc.begin_decision();
+	if (!proc.running())
+	{
+		if (!proc.start(bot.first))
+		{
+			cerr << "Error: cannot start bot " << bot.first << endl;
+			return nullptr;
+		}
+		fresh = true;
+	}
+	if (!proc.send_line(fresh ? t.input() : t.last_request()))
+	{
+		proc.stop();
+		return nullptr;
+	}
+	return &proc;
+}
+
+// 一轮的发牌
+struct Deal {
+	CardSet hands[3];
+	CardSet publics;
+};
+
+// 三个人坐进三个座位的全部排列
+constexpr int SEAT_ORDERS[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+
+// 一桌比赛: 玩家 players[0..2] 依次坐在 0..2 号座位
+// duplicate 模式下同一桌依次打 rotations 局，每局换一种座位排列
+struct Match {
+	Table table;
+	int players[3] = {};
+	BotProcess procs[3];  // 本桌各座位单次启动的进程，keep_running: game 时为常驻进程
+	NativeBot natives[3]; // 本桌各座位的插件实例
+	int trio[3] = {};     // 本桌的三位玩家
+	int rotation = 0;
+	int rotations = 1;
+	const Deal* deal = nullptr;
+	int game_no = 0;
+	int slot = 0;         // 所属轮次在流水线中的位置，也是成绩表中增量的位置
+	long long trio_score[3] = {};  // 三位玩家在本桌 (全部座位排列) 的得分，用于更新评分
+	// 限制每个 bot 同时只打一局时，本桌要等同一玩家上一次所在的桌打完
+	int waiting = 0;      // 还没打完的前驱桌数
+	bool done = false;
+	Match* next[3] = {};  // 等待本桌的后继桌
+	int next_count = 0;
+	// 叫分的推测进程: [b0] 为座位 1 在座位 0 叫 b0 时的决策，[4 + 4 * b0 + b1] 为座位 2 的决策
+	BotProcess speculation[20];
+	int speculating = 0;  // 其中正在运行的进程数
+	Arena speculation_arena;
+	Transcript speculation_input;  // 正在启动的推测决策的输入
+
+	void start()
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			players[j] = trio[SEAT_ORDERS[rotation][j]];
+			natives[j].bind(plugins[players[j]]);
+			table.native[j] = plugins[players[j]] != nullptr;
 		}
+		table.start(deal->hands, deal->publics);
 	}
+
+	// 开始下一种座位排列，全部打完时返回 false
+	bool next_rotation()
+	{
+		if (++rotation >= rotations) return false;
+		start();
+		return true;
+	}
+};
+
+// 在当前线程上调用插件完成一次决策，同样统计耗时并检查限制 (超限只能在返回之后判负)
+void native_decision(Match& match)
+{
+	Table& t = match.table;
+	NativeBot& bot = match.natives[t.turn];
+	auto began = BotProcess::Clock::now();
+	double cpu_base = thread_cpu_ms();
+	uint64_t bid = 0, play = 0;
+	if (t.phase == Table::BIDDING) bid = bot.bid(t.bid_request());
+	else play = bot.play(t.play_request());
+	double wall = std::chrono::duration<double, std::milli>(BotProcess::Clock::now() - began).count();
+	double cpu = thread_cpu_ms() - cpu_base;
+	trace::elapsed(trace::BOT, match.players[t.turn], match.game_no, wall, false);
+	trace::Scope scope(trace::FEED, match.players[t.turn], match.game_no);
+	const char* overrun = LIMITS.exceeded(wall, cpu);
+	scoreboard.local(match.slot, match.players[t.turn]).record(wall, cpu, 0, overrun != nullptr);
+	if (overrun) t.fail(overrun);
+	else if (t.phase == Table::BIDDING) t.feed_bid((int)(int32_t)bid);
+	else if (play >> CARD_COUNT) t.fail("invalid or repeated card");
+	else t.feed_play(CardSet(play));
+}
+
+// 推测进程 slot 对应的座位和假设的叫分
+int speculation_seat(int slot, int bids[2])
+{
+	if (slot < 4)
+	{
+		bids[0] = slot;
+		return 1;
+	}
+	bids[0] = (slot - 4) / 4;
+	bids[1] = (slot - 4) % 4;
+	return 2;
+}
+
+// 结束已经不可能用到的推测进程，返回与实际叫分一致、正轮到的那个 (没有时为 nullptr)
+BotProcess* resolve_speculation(Match& match)
+{
+	const Table& t = match.table;
+	BotProcess* current = nullptr;
+	for (int slot = 0; slot < 20 && match.speculating > 0; slot++)
+	{
+		BotProcess& proc = match.speculation[slot];
+		if (!proc.running()) continue;
+		int bids[2];
+		int seat = speculation_seat(slot, bids);
+		bool possible = t.phase == Table::BIDDING && seat >= t.turn;
+		for (int i = 0; i < seat && i < t.turn; i++) possible = possible && bids[i] == t.player_bid[i];
+		if (possible && seat == t.turn) current = &proc;
+		else if (!possible)
+		{
+			proc.stop();
+			match.speculating--;
+			speculation_running--;
+			speculation_cancelled++;
+		}
+	}
+	return current;
+}
+
+// 按已知的叫分提前启动后面座位所有可能的叫分决策，先启动近的座位，超出推测预算时停止
+void speculate(Match& match)
+{
+	const Table& t = match.table;
+	for (int seat = t.turn + 1; seat < 3; seat++)
+	{
+		int id = match.players[seat];
+		if (!speculative[id]) continue;
+		// 座位 turn..seat-1 的叫分未知，各枚举 0..3
+		int unknown = seat - t.turn;
+		for (int k = 0; k < 1 << (2 * unknown); k++)
+		{
+			int bids[2];
+			for (int i = 0; i < seat; i++) bids[i] = i < t.turn ? t.player_bid[i] : k >> (2 * (i - t.turn)) & 3;
+			BotProcess& proc = match.speculation[seat == 1 ? bids[0] : 4 + 4 * bids[0] + bids[1]];
+			if (proc.running()) continue;
+			if (speculation_running.fetch_add(1) >= SPECULATION_BUDGET)
+			{
+				speculation_running--;
+				return;
+			}
+			match.speculation_arena.reset();
+			match.speculation_input.reset(&match.speculation_arena);
+			t.bid_request_for(seat, bids, match.speculation_input);
+			if (!spawn_once(id, match.speculation_input, proc))
+			{
+				speculation_running--;
+				continue;
+			}
+			match.speculating++;
+			speculation_launched++;
+		}
+	}
+}
+
+// 发起座位 turn 的一次决策，不等待结果
+Decision launch_decision(Match& match)
+{
+	Table& t = match.table;
+	int id = match.players[t.turn];
+	Decision d;
+	BotProcess* speculated = match.speculating > 0 ? resolve_speculation(match) : nullptr;
+	if (match.natives[t.turn].get())
+	{
+		native_decision(match);
+		d.done = true;
+		return d;
+	}
+	trace::Scope scope(trace::LAUNCH, id, match.game_no);
+	if (!keep_running_enabled(id))
+	{
+		// 常驻进程要看到每一条请求，只有单次启动的决策可以直接用缓存的结果
+		if (cache_seed[id])
+		{
+			string output;
+			d.cacheable = true;
+			d.cache_key = hash_bytes(t.transcript[t.turn].input(), cache_seed[id]);
+			if (decision_cache.find(d.cache_key, output))
+			{
+				t.feed(output);
+				d.done = true;
+				return d;
+			}
+		}
+		d.until_eof = true;
+		if (speculated)
+		{
+			// 提前启动的进程收到的输入与现在的相同；墙钟时间从接管时算起，即本桌实际等待的时间
+			match.procs[t.turn].take(*speculated);
+			match.procs[t.turn].restart_clock();
+			d.proc = &match.procs[t.turn];
+			match.speculating--;
+			speculation_running--;
+			speculation_used++;
+		}
+		else if (spawn_once(id, t.transcript[t.turn], match.procs[t.turn])) d.proc = &match.procs[t.turn];
+	}
+	else d.proc = send_to_resident(id, t.transcript[t.turn], match.procs[t.turn]);
+	if (t.phase == Table::BIDDING && t.turn < 2 && SPECULATION_BUDGET > 0) speculate(match);
+	return d;
+}
+
+// 一次决策结束：记录资源占用，超限的一方判负，否则把输出交给本桌
+// 超限可能在等待时发现 (overrun 非空，进程已被结束)，也可能在得到结果后才从 CPU 时间发现
+void complete_decision(Match& match, const Decision& d, const string& output, const char* overrun)
+{
+	Table& t = match.table;
+	int id = match.players[t.turn];
+	if (!d.proc) return t.feed(output);  // 启动失败，按输出为空处理
+	Usage usage = d.proc->usage();
+	trace::elapsed(trace::BOT, id, match.game_no, usage.wall_ms, true);
+	trace::Scope scope(trace::FEED, id, match.game_no);
+	if (!overrun && (overrun = LIMITS.exceeded(usage.wall_ms, usage.cpu_ms))) d.proc->stop();
+	if (d.cacheable && !overrun && !output.empty()) decision_cache.insert(d.cache_key, output);
+	PlayerScore& ps = scoreboard.local(match.slot, id);
+	ps.record(usage.wall_ms, usage.cpu_ms, usage.peak_rss_kb, overrun != nullptr);
+	if (overrun) t.fail(overrun);
+	else t.feed(output);
+}
+
+// 让 bot 做一次决策并阻塞等待结果
+void play_turn(Match& match)
+{
+	Decision d = launch_decision(match);
+	if (d.done) return;
+	string output;
+	const char* overrun = d.proc ? d.proc->await(output, d.until_eof, LIMITS) : nullptr;
+	complete_decision(match, d, output, overrun);
+}
+
+#ifndef _WIN32
+TableScheduler<Match> scheduler;
 #endif
-	if ((ptr = _popen(ps, "r")) != NULL)
+
+// 把一局写进当前工作线程的对局记录
+void record_replay(const Match& match, ReplayWriter& out)
+{
+	const Table& t = match.table;
+	ReplayGame game = {};
+	game.game_no = match.game_no;
+	game.rotation = match.rotation;
+	for (int i = 0; i < 3; i++)
+	{
+		game.players[i] = match.players[i];
+		game.bids[i] = t.player_bid[i] < 0 ? REPLAY_NONE : t.player_bid[i];
+		game.hands[i] = t.initial_cards[i].mask();
+	}
+	game.landlord = t.landlord_position < 0 ? REPLAY_NONE : t.landlord_position;
+	game.winner = t.winner < 0 ? REPLAY_NONE : t.winner;
+	game.forfeit = t.forfeit < 0 ? REPLAY_NONE : t.forfeit;
+	game.score = t.score;
+	game.play_count = t.plays.size();
+	game.publics = t.public_cards.mask();
+	out.write(game, t.plays.data());
+}
+
+// 记录一局的结果，写入所属轮次的成绩增量；同一轮各桌的玩家互不相同，不需要加锁
+// 残局分析，结果记入这一轮的成绩增量；在结算所在的工作线程上进行，各桌并行
+void analyze_endgame(const Match& match)
+{
+	thread_local endgame::Solver solver;
+	trace::Scope scope(trace::ENDGAME, -1, match.game_no);
+	const Table& t = match.table;
+	endgame::Regret regret = endgame::analyze(t.initial_cards, t.public_cards, t.landlord_position, t.plays,
+	                                          ENDGAME_CARDS, ENDGAME_NODE_LIMIT, solver);
+	for (int i = 0; i < 3; i++)
+	{
+		PlayerScore& ps = scoreboard.local(match.slot, match.players[i]);
+		ps.endgame_decisions += regret.decisions[i];
+		ps.endgame_blunders += regret.blunders[i];
+	}
+}
+
+void settle(Match& match)
+{
+	const Table& t = match.table;
+	const int* p = match.players;
+	int game_no = match.game_no;
+	if (match.speculating > 0) resolve_speculation(match);  // 叫分阶段判负时剩下的推测进程
+	if (ENDGAME_CARDS > 0 && t.landlord_position >= 0) analyze_endgame(match);
+	trace::Scope scope(trace::SETTLE, -1, game_no);
+	if (!replays.empty()) record_replay(match, replays[omp_get_thread_num()]);
+	for (int i = 0; i < 3; i++)
+	{
+		PlayerScore& ps = scoreboard.local(match.slot, p[i]);
+		ps.score += t.delta(i);
+		match.trio_score[SEAT_ORDERS[match.rotation][i]] += t.delta(i);
+		if (t.won(i)) ps.wins++;
+	}
+	for (int i = 0; i < 3; i++) match.procs[i].stop();
+	if (t.forfeit >= 0)
 	{
-		while (fgets(buf_ps, 2048, ptr) != NULL)strcat_s(result, buf_ps);
-		_pclose(ptr);
-		ptr = NULL;
+		scoreboard.local(match.slot, p[t.forfeit]).forfeits++;
+		cerr << "Forfeit: " << bots[p[t.forfeit]].second << " " << t.forfeit_reason << " in game " << game_no << endl;
+#ifndef PARALLEL
+		cout << "game " << game_no << " is over, forfeit: " << bots[p[t.forfeit]].first << "; score: " << t.score << endl;
+#endif
+		return;
 	}
-	else cout << "_popen " << ps << " error" << endl;
-	string ret(result);
-	return ret;
+#ifndef PARALLEL
+	cout << "game " << game_no << " is ";
+	cout << "over, winner: " << bots[p[t.winner]].first;
+	if (t.winner != t.landlord_position) cout << ", " << bots[p[3-t.winner-t.landlord_position]].first;
+	cout << "; landlord: " << bots[p[t.landlord_position]].first;
+	cout << "; score: " << t.score << endl;
+#endif
 }
 
 const vector<string> colors = {
@@ -105,8 +527,27 @@ const vector<string> colors = {
     "\033[36m"  // 青
 };
 
-// 加载配置并初始化 bots
-bool load_config() {
+// 加载进程内插件，同一个文件只加载一次；内置参考 bot 不需要加载
+bool load_plugins() {
+    plugins.assign(bots.size(), nullptr);
+    for (size_t i = 0; i < bots.size(); i++) {
+        if (bots[i].first == REFERENCE_BOT) {
+            plugins[i] = reference_plugin();
+            continue;
+        }
+        if (!is_plugin_file(fs::path(bots[i].first).extension().string())) continue;
+        string error;
+        plugins[i] = load_plugin(bots[i].first, error);
+        if (!plugins[i]) {
+            cerr << "Error: cannot load plugin " << bots[i].first << ": " << error << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// 加载配置并初始化 bots，命令行参数 (--shard i/n, --seed s, --game r) 覆盖配置文件
+bool load_config(int argc, char* argv[]) {
     SimpleYamlParser config;
     
     // 尝试从当前目录加载 config.yaml
@@ -119,6 +560,159 @@ bool load_config() {
     PLAYER_NUMBER = config.getInt("player_number", 12);
     BOT_DIR = config.getString("bot_dir", "bots");
     DEFAULT_BOT = config.getString("default_bot", "demo");
+    KEEP_RUNNING = config.getString("keep_running", "off");
+    if (KEEP_RUNNING != "off" && KEEP_RUNNING != "game" && KEEP_RUNNING != "tournament") {
+        cerr << "Error: keep_running must be off, game or tournament" << endl;
+        return false;
+    }
+    BOT_INPUT = config.getString("bot_input", "argv");
+    if (BOT_INPUT != "argv" && BOT_INPUT != "stdin") {
+        cerr << "Error: bot_input must be argv or stdin" << endl;
+        return false;
+    }
+    PRESPAWN = config.getInt("prespawn", 0);
+    if (PRESPAWN < 0 || (PRESPAWN > 0 && BOT_INPUT != "stdin")) {
+        cerr << "Error: prespawn must not be negative and needs bot_input: stdin" << endl;
+        return false;
+    }
+    LIMITS.wall_ms = config.getInt("time_limit_ms", 0);
+    LIMITS.cpu_ms = config.getInt("cpu_limit_ms", 0);
+    if (LIMITS.wall_ms < 0 || LIMITS.cpu_ms < 0) {
+        cerr << "Error: time_limit_ms and cpu_limit_ms must not be negative" << endl;
+        return false;
+    }
+    MAX_INFLIGHT_ROUNDS = config.getInt("max_inflight_rounds", 0);
+    ONE_GAME_PER_BOT = config.getString("one_game_per_bot", "off");
+    if (ONE_GAME_PER_BOT != "off" && ONE_GAME_PER_BOT != "on") {
+        cerr << "Error: one_game_per_bot must be off or on" << endl;
+        return false;
+    }
+    if (KEEP_RUNNING == "tournament") ONE_GAME_PER_BOT = "on";
+    REPLAY_DIR = config.getString("replay_dir", "");
+    DECISION_CACHE_SIZE = config.getInt("decision_cache_size", 65536);
+    stringstream deterministic_list(config.getString("deterministic_bots", ""));
+    for (string name; getline(deterministic_list, name, ',');) {
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (!name.empty()) deterministic_bots.insert(name);
+    }
+    stringstream speculative_list(config.getString("speculative_bots", ""));
+    for (string name; getline(speculative_list, name, ',');) {
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (!name.empty()) speculative_bots.insert(name);
+    }
+    SPECULATION_BUDGET = config.getInt("speculation_budget", 0);
+    if (SPECULATION_BUDGET < 0) {
+        cerr << "Error: speculation_budget must not be negative" << endl;
+        return false;
+    }
+    MATCHMAKING = config.getString("matchmaking", "random");
+    if (MATCHMAKING != "random" && MATCHMAKING != "adaptive") {
+        cerr << "Error: matchmaking must be random or adaptive" << endl;
+        return false;
+    }
+    EARLY_STOP_TOP_K = config.getInt("early_stop_top_k", 0);
+    EARLY_STOP_CONFIDENCE = config.getInt("early_stop_confidence", 95);
+    EARLY_STOP_MIN_GAMES = config.getInt("early_stop_min_games", 10);
+    if (EARLY_STOP_CONFIDENCE <= 0 || EARLY_STOP_CONFIDENCE >= 100) {
+        cerr << "Error: early_stop_confidence must be between 1 and 99" << endl;
+        return false;
+    }
+    CHECKPOINT_FILE = config.getString("checkpoint_file", "");
+    CHECKPOINT_INTERVAL = config.getInt("checkpoint_interval", 100);
+    if (CHECKPOINT_INTERVAL <= 0) {
+        cerr << "Error: checkpoint_interval must be positive" << endl;
+        return false;
+    }
+    TRACE_FILE = config.getString("trace_file", "");
+    TRACE_BUFFER = config.getInt("trace_buffer", 262144);
+    if (TRACE_BUFFER <= 0) {
+        cerr << "Error: trace_buffer must be positive" << endl;
+        return false;
+    }
+    ENDGAME_CARDS = config.getInt("endgame_cards", 0);
+    ENDGAME_NODE_LIMIT = config.getInt("endgame_node_limit", 200000);
+    if (ENDGAME_CARDS < 0 || ENDGAME_CARDS > 20 || ENDGAME_NODE_LIMIT <= 0) {
+        cerr << "Error: endgame_cards must be between 0 and 20 and endgame_node_limit positive" << endl;
+        return false;
+    }
+    UPLINK = config.getString("uplink", "stdout");
+    BACKEND_URL = config.getString("backend_url", BACKEND_URL);
+    UPLINK_INTERVAL_MS = config.getInt("uplink_interval_ms", 100);
+    if (UPLINK != "stdout" && UPLINK != "websocket") {
+        cerr << "Error: uplink must be stdout or websocket" << endl;
+        return false;
+    }
+    if (UPLINK_INTERVAL_MS <= 0) {
+        cerr << "Error: uplink_interval_ms must be positive" << endl;
+        return false;
+    }
+    SHARD_ID = config.getInt("shard_id", 0);
+    SHARD_COUNT = config.getInt("shard_count", 1);
+    string seed = config.getString("seed", "");
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        if (arg == "--shard" && sscanf(argv[i + 1], "%d/%d", &SHARD_ID, &SHARD_COUNT) == 2) continue;
+        if (arg == "--seed") {
+            seed = argv[i + 1];
+            continue;
+        }
+        if (arg == "--game" && sscanf(argv[i + 1], "%d", &ONLY_GAME) == 1) continue;
+        cerr << "Error: unknown argument " << arg << " (usage: main [--shard i/n] [--seed s] [--game r])" << endl;
+        return false;
+    }
+    if (SHARD_COUNT < 1 || SHARD_ID < 0 || SHARD_ID >= SHARD_COUNT) {
+        cerr << "Error: shard must satisfy 0 <= shard_id < shard_count" << endl;
+        return false;
+    }
+    if (ONLY_GAME >= TOTAL_GAMES) {
+        cerr << "Error: --game must be less than total_games" << endl;
+        return false;
+    }
+    if (ONLY_GAME >= 0 && seed.empty()) {
+        cerr << "Error: --game needs the seed of the tournament (--seed s)" << endl;
+        return false;
+    }
+    SEED_GIVEN = !seed.empty();
+    SEED = SEED_GIVEN ? strtoull(seed.c_str(), nullptr, 10) : (uint64_t)time(0);
+    // 各分片写各自的检查点
+    if (!CHECKPOINT_FILE.empty() && SHARD_COUNT > 1) CHECKPOINT_FILE += "." + to_string(SHARD_ID);
+    DEAL_BANK = config.getString("deal_bank", "");
+    if (!DEAL_BANK.empty()) {
+        if (!deal_bank.open(DEAL_BANK)) {
+            cerr << "Error: cannot load deal bank " << DEAL_BANK << ": " << deal_bank.error() << endl;
+            return false;
+        }
+        if (deal_bank.size_in_deals() < (uint64_t)TOTAL_GAMES) {
+            cerr << "Error: deal bank " << DEAL_BANK << " has " << deal_bank.size_in_deals()
+                 << " deals, fewer than total_games" << endl;
+            return false;
+        }
+    }
+    DEAL_MODE = config.getString("deal_mode", "single");
+    if (DEAL_MODE != "single" && DEAL_MODE != "duplicate") {
+        cerr << "Error: deal_mode must be single or duplicate" << endl;
+        return false;
+    }
+    SCHEDULER = config.getString("scheduler", "omp");
+    MAX_INFLIGHT_TABLES = config.getInt("max_inflight_tables", 0);
+    if (SCHEDULER != "omp" && SCHEDULER != "epoll") {
+        cerr << "Error: scheduler must be omp or epoll" << endl;
+        return false;
+    }
+#ifdef _WIN32
+    if (SCHEDULER == "epoll") {
+        cerr << "Warning: epoll scheduler is not available on Windows, using omp" << endl;
+        SCHEDULER = "omp";
+    }
+#endif
+    stringstream keep_list(config.getString("keep_running_bots", ""));
+    for (string name; getline(keep_list, name, ',');) {
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (!name.empty()) keep_running_bots.insert(name);
+    }
 
     // 扫描 bot 目录
     vector<string> bot_files;
@@ -127,7 +721,8 @@ bool load_config() {
     try {
         if (fs::exists(bot_path) && fs::is_directory(bot_path)) {
             for (const auto& entry : fs::directory_iterator(bot_path)) {
-                if (entry.is_regular_file() && entry.path().extension() == ".exe") {
+                string ext = entry.path().extension().string();
+                if (entry.is_regular_file() && (ext == ".exe" || is_plugin_file(ext))) {
                     bot_files.push_back(entry.path().filename().string());
                 }
             }
@@ -143,19 +738,21 @@ bool load_config() {
         for (int i = 0; i < PLAYER_NUMBER; i++) {
             bots.push_back({DEFAULT_BOT, "Player" + to_string(i + 1)});
         }
-        return true;
+        return load_plugins();
     }
 
     // 填充 bots 数组，使用完整路径
-	string default_bot_path = BOT_DIR + "/" + DEFAULT_BOT;
+	// default_bot 不写后缀名，按扫描到的文件补全 (POSIX 上启动进程不会自动补 .exe)
+	string default_bot_path = DEFAULT_BOT == REFERENCE_BOT ? DEFAULT_BOT : BOT_DIR + "/" + DEFAULT_BOT;
+	for (const string& file : bot_files)
+		if (DEFAULT_BOT != REFERENCE_BOT && fs::path(file).stem().string() == DEFAULT_BOT)
+			default_bot_path = BOT_DIR + "/" + file;
     bots.clear();
     for (size_t i = 0; i < bot_files.size() && bots.size() < (size_t)PLAYER_NUMBER; i++) {
         string bot_name = bot_files[i];
         string player_name = bot_name.substr(0, bot_name.find_last_of('.'));
         string full_path = BOT_DIR + "/" + bot_name;
-		string path_without_suffix = full_path.substr(0, full_path.find_last_of('.'));
-		// cout<<"Debug: "<<path_without_suffix<<' '<<default_bot_path<<"\n";
-		if(path_without_suffix == default_bot_path) continue;
+		if(full_path == default_bot_path) continue;
         bots.push_back({full_path, player_name});
     }
 	
@@ -167,424 +764,558 @@ bool load_config() {
         bots.push_back({default_bot_path, "Default" + to_string(i - current_count + 1)});
     }
 
-    return true;
+    return load_plugins();
+}
+
+// 输出一条给后端的消息：连上后端时交给上行通道，否则按原来的 JSON_DATA: 行输出到 stdout；
+// snapshot 为完整覆盖上一条同类消息的排名，resend 为重连后需要重发的消息
+void emit(const string& json, bool snapshot, bool resend = false)
+{
+    if (uplink.running()) uplink.send(json, snapshot, resend);
+    else cout << "JSON_DATA:" << json << endl;
 }
 
 void print_init()
 {
     stringstream ss;
-    ss << "JSON_DATA:{\"type\":\"init\",\"total_games\":" << TOTAL_GAMES 
+    ss << "{\"type\":\"init\",\"total_games\":" << TOTAL_GAMES 
+       << ",\"deal_mode\":\"" << DEAL_MODE << "\""
+       << ",\"shard\":" << SHARD_ID << ",\"shards\":" << SHARD_COUNT << ",\"seed\":" << SEED
+       << ",\"resumed\":" << completed_rounds.size()
        << ",\"player_number\":" << PLAYER_NUMBER << ",\"players\":[";
 
     for(int i=0; i<PLAYER_NUMBER; i++)
     {
         if(i > 0) ss << ","; // 输出玩家的名称和对应的exe文件名
-        ss << "{\"name\":\"" << bots[i].second << "\",\"exe\":\"" << bots[i].first << "\"}";
+        ss << "{\"name\":\"" << json_escape(bots[i].second) << "\",\"exe\":\"" << json_escape(bots[i].first) << "\"}";
     }
     ss << "]}";
-    
-    // 立即输出并刷新缓冲区
-    cout << ss.str() << endl;
+    emit(ss.str(), false, true);
+}
+
+// 排名：adaptive 排座时各人的对手强弱不同，总分不可比，改按评分
+vector<int> standings()
+{
+    return MATCHMAKING == "adaptive" ? ratings.ranking() : scoreboard.ranking();
 }
 
 // 替换原有的 print_rank 函数
 void print_rank(int game_num)
 {
     // 1. 排序
-    sort(bots.begin(), bots.end(), [](const pair<string, string>& a, const pair<string, string>& b) {
-        return player_winning_scores[a.second] > player_winning_scores[b.second];
-    });
+    vector<int> order = standings();
 
     // 2. 构建 JSON 字符串
-    // 手动构建 JSON 字符串以避免依赖外部库的复杂性，确保格式为 JSON_DATA:{...}
+    // 手动构建 JSON 字符串以避免依赖外部库的复杂性
     stringstream ss;
-    ss << "JSON_DATA:{\"type\":\"rank_update\",\"game_num\":" << game_num 
+    ss << "{\"type\":\"rank_update\",\"game_num\":" << game_num 
        << ",\"total_games\":" << TOTAL_GAMES << ",\"data\":[";
 
     for (int i = 0; i < PLAYER_NUMBER; i++)
     {
-        auto [exe_name, name] = bots[i];
+        auto [exe_name, name] = bots[order[i]];
+        const PlayerScore& ps = scoreboard[order[i]];
         if (i > 0) ss << ",";
         ss << "{\"rank\":" << (i + 1)
-           << ",\"name\":\"" << name << "\""
-           << ",\"exe\":\"" << exe_name << "\""
-           << ",\"score\":" << player_winning_scores[name]
-           << ",\"wins\":" << player_winning_rounds[name] << "}";
+           << ",\"name\":\"" << json_escape(name) << "\""
+           << ",\"exe\":\"" << json_escape(exe_name) << "\""
+           << ",\"score\":" << ps.score
+           << ",\"deal_score\":" << scoreboard.last_round(order[i])
+           << ",\"wins\":" << ps.wins
+           << ",\"forfeits\":" << ps.forfeits
+           << ",\"timeouts\":" << ps.timeouts
+           << ",\"decisions\":" << ps.decisions()
+           << ",\"p50_ms\":" << ps.latency.quantile(0.5)
+           << ",\"p99_ms\":" << ps.latency.quantile(0.99)
+           << ",\"cpu_ms\":" << (long long)ps.cpu_ms
+           << ",\"peak_rss_kb\":" << ps.peak_rss_kb
+           << ",\"endgame_decisions\":" << ps.endgame_decisions
+           << ",\"endgame_blunders\":" << ps.endgame_blunders
+           << ",\"rating\":" << (long long)ratings.rating(order[i])
+           << ",\"rating_ci\":" << (long long)ratings.interval(order[i]) << "}";
     }
     ss << "]}";
 
-    // 3. 输出并刷新缓冲区 (非常重要)
-    cout << ss.str() << endl;
+    // 3. 输出
+    emit(ss.str(), true);
 }
 
-int main()
+// 分片模式下代替 rank_update：本分片到目前为止的累计成绩，按玩家 id 排列，
+// 各项都可以跨分片直接相加 (延迟直方图逐段相加、评分按精度加权)，games_done 为本分片已输出的轮数
+void print_partial(int game_num, int games_done)
 {
-	#ifdef _WIN32
-    SetConsoleOutputCP(65001); 
-    #endif
-    // 加载配置
-    if (!load_config()) {
-        cerr << "Failed to load configuration" << endl;
-        return 1;
+    stringstream ss;
+    ss << "{\"type\":\"partial\",\"shard\":" << SHARD_ID << ",\"shards\":" << SHARD_COUNT
+       << ",\"game_num\":" << game_num << ",\"games_done\":" << games_done
+       << ",\"total_games\":" << TOTAL_GAMES << ",\"rank_by\":\"" << (MATCHMAKING == "adaptive" ? "rating" : "score")
+       << "\",\"data\":[";
+    for (int i = 0; i < PLAYER_NUMBER; i++)
+    {
+        const PlayerScore& ps = scoreboard[i];
+        if (i > 0) ss << ",";
+        ss << "{\"id\":" << i
+           << ",\"name\":\"" << json_escape(bots[i].second) << "\""
+           << ",\"exe\":\"" << json_escape(bots[i].first) << "\""
+           << ",\"score\":" << ps.score
+           << ",\"deal_score\":" << scoreboard.last_round(i)
+           << ",\"wins\":" << ps.wins
+           << ",\"forfeits\":" << ps.forfeits
+           << ",\"timeouts\":" << ps.timeouts
+           << ",\"decisions\":" << ps.decisions()
+           << ",\"cpu_ms\":" << (long long)ps.cpu_ms
+           << ",\"peak_rss_kb\":" << ps.peak_rss_kb
+           << ",\"endgame_decisions\":" << ps.endgame_decisions
+           << ",\"endgame_blunders\":" << ps.endgame_blunders
+           << ",\"rating\":" << ratings.rating(i)
+           << ",\"rating_rd\":" << ratings.deviation(i)
+           << ",\"latency\":[";
+        bool first = true;
+        ps.latency.for_each_bucket([&](int bucket, unsigned count) {
+            ss << (first ? "" : ",") << "[" << bucket << "," << count << "]";
+            first = false;
+        });
+        ss << "]}";
     }
+    ss << "]}";
+    emit(ss.str(), true);
+}
 
-    // 初始化 Final_score
-    for (const auto& bot : bots) {
-        Final_score[bot.first].init(TOTAL_GAMES);
-        player_winning_rounds[bot.second] = 0;
-        player_winning_scores[bot.second] = 0;
-    }
+// 检查点中的比赛参数，续打时必须与当前配置一致，否则已有的成绩没有意义
+struct TournamentParams {
+	uint64_t seed = 0;
+	int32_t total_games = 0, shard_id = 0, shard_count = 0;
+	string deal_mode, matchmaking;
+	uint64_t deal_bank_seed = 0;  // 牌库生成时的种子，不用牌库时为 0
+	vector<string> exes;  // 按玩家 id
 
-    // cout << colors[0] << "(test)" << "\033[0m" << '\n';
-	// freopen("result.txt","w",stdout);
-	print_init();
-	auto start = std::chrono::high_resolution_clock::now();
-	for(int game_no = 0; game_no<TOTAL_GAMES; game_no++) 
+	static TournamentParams current()
 	{
-		vector<short> cards;
-		set<short> player_initial_cards[3];
-		set<short> public_cards;
-		for(short card=0; card<54; card++)
-            cards.push_back(card);
-		shuffle(cards.begin(), cards.end(), rng);
-        shuffle(bots.begin(), bots.end(), rng);
-
-        for (int i=0; i<3; i++)
-        {
-            player_initial_cards[i].clear();
-			player_initial_cards[i].insert(cards.begin()+i*17, cards.begin()+(i+1)*17);
-        }
-		public_cards.clear();
-		public_cards.insert(cards.begin()+51, cards.begin()+54);
+		TournamentParams p;
+		p.seed = SEED;
+		p.total_games = TOTAL_GAMES;
+		p.shard_id = SHARD_ID;
+		p.shard_count = SHARD_COUNT;
+		p.deal_mode = DEAL_MODE;
+		p.matchmaking = MATCHMAKING;
+		p.deal_bank_seed = deal_bank.is_open() ? deal_bank.info().seed : 0;
+		for (const auto& bot : bots) p.exes.push_back(bot.first);
+		return p;
+	}
 
-#ifdef PARALLEL
-        #pragma omp parallel for
-#endif
-        for(int now=0; now<PLAYER_NUMBER; now+=3) //bot [now, now+1, now+2] in a battle
-        {
-            int score = 1;
-            int landlord_position;
-            set<short> player_cards[3];
-            vector<string> requests[3];
-		    vector<string> responses[3];
-			for(int i=0; i<3; i++) requests[i].clear();
-			for(int i=0; i<3; i++) responses[i].clear();
-			for(int i=0; i<3; i++) player_cards[i] = player_initial_cards[i];
-			int player_bid[3];
-			int final_bid;
-			string requests0, responses0, cmd0;
-			requests0 += "{\"\"\"own\"\"\":[";
-			requests0 += to_string(*player_cards[0].begin());
-			for (set<short>::iterator i = next(player_cards[0].begin()); i != player_cards[0].end(); i++)
-			{
-				requests0 += ",";
-				requests0 += to_string(*i);
-			}
-			requests0 += "],\"\"\"bid\"\"\":[]}";
-			responses0 = "";
-			requests[0].push_back(requests0);
-			cmd0 = bots[now].first + " \"{\"\"requests\"\"\":[" + requests0 + "],\"\"\"responses\"\"\":[" + responses0 + "]}\"";
-			string response0;
-			response0 = get_response(cmd0.c_str());
-			
-			Json::Reader reader;
-			Json::Value input0;
-			reader.parse(response0, input0);
-			player_bid[0] = input0["response"].asInt();
-			responses[0].push_back(to_string(player_bid[0]));
-			// cout << "player_bid[" << bots_no[sub_game][0] << "]: " << player_bid[0] << endl;
-			string requests1, responses1, cmd1;
-			requests1 += "{\"\"\"own\"\"\":[";
-			requests1 += to_string(*player_cards[1].begin());
-			for (set<short>::iterator i = next(player_cards[1].begin()); i != player_cards[1].end(); i++)
-			{
-				requests1 += ",";
-				requests1 += to_string(*i);
-			}
-			requests1 += "],\"\"\"bid\"\"\":[";
-			requests1 += to_string(player_bid[0]);
-			requests1 += "]}";
-			responses1 = "";
-			requests[1].push_back(requests1);
-			cmd1 = bots[now+1].first + " \"{\"\"requests\"\"\":[" + requests1 + "],\"\"\"responses\"\"\":[" + responses1 + "]}\"";
-			//cout << "cmd1: " << cmd1 << endl;
-			string response1;
-			response1 = get_response(cmd1.c_str());
-			
-			Json::Value input1;
-			reader.parse(response1, input1);
-			player_bid[1] = input1["response"].asInt();
-			responses[1].push_back(to_string(player_bid[1]));
-			//cout << "player_bid[" << bots_no[sub_game][1] << "]: " << player_bid[1] << endl;
-			string requests2, responses2, cmd2;
-			requests2 += "{\"\"\"own\"\"\":[";
-			requests2 += to_string(*player_cards[2].begin());
-			for (set<short>::iterator i = next(player_cards[2].begin()); i != player_cards[2].end(); i++)
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar.io(seed);
+		ar.io(total_games);
+		ar.io(shard_id);
+		ar.io(shard_count);
+		ar.io(deal_mode);
+		ar.io(matchmaking);
+		ar.io(deal_bank_seed);
+		ar.io(exes);
+	}
+};
+
+// 写入检查点，只能在没有轮次正在合并时调用 (由流水线在锁内调用)
+void save_checkpoint()
+{
+	CheckpointWriter out;
+	CheckpointHeader header;
+	TournamentParams params = TournamentParams::current();
+	header.serialize(out);
+	params.serialize(out);
+	completed_rounds.serialize(out);
+	scoreboard.serialize(out);
+	ratings.serialize(out);
+	if (!out.commit(CHECKPOINT_FILE)) cerr << "Warning: cannot write checkpoint " << CHECKPOINT_FILE << endl;
+}
+
+// 从已有的检查点恢复成绩、评分和已打完的轮次；文件不存在时返回 true
+bool load_checkpoint()
+{
+	CheckpointReader in;
+	if (!in.open(CHECKPOINT_FILE)) return true;
+	CheckpointHeader header;
+	header.serialize(in);
+	if (in.failed() || header.magic != CHECKPOINT_MAGIC || header.version != CHECKPOINT_VERSION)
+	{
+		cerr << "Error: " << CHECKPOINT_FILE << " is not a checkpoint of this version" << endl;
+		return false;
+	}
+	TournamentParams saved, now = TournamentParams::current();
+	saved.serialize(in);
+	if (!SEED_GIVEN) now.seed = saved.seed;
+	if (saved.seed != now.seed || saved.total_games != now.total_games || saved.shard_id != now.shard_id
+		|| saved.shard_count != now.shard_count || saved.deal_mode != now.deal_mode
+		|| saved.matchmaking != now.matchmaking || saved.deal_bank_seed != now.deal_bank_seed || saved.exes != now.exes)
+	{
+		cerr << "Error: checkpoint " << CHECKPOINT_FILE << " belongs to a different tournament"
+		     << " (seed, total_games, shard, deal_mode, deal_bank, matchmaking or bots changed); remove it to start over" << endl;
+		return false;
+	}
+	SEED = saved.seed;
+	completed_rounds.serialize(in);
+	scoreboard.serialize(in);
+	ratings.serialize(in);
+	if (!in.ok())
+	{
+		cerr << "Error: checkpoint " << CHECKPOINT_FILE << " is truncated or corrupt" << endl;
+		return false;
+	}
+	return true;
+}
+
+// 本进程要打的轮次: 本分片中还没有打完的轮次，--game 时只打指定的一轮
+vector<int> pending_rounds()
+{
+	if (ONLY_GAME >= 0) return {ONLY_GAME};
+	vector<int> games;
+	for (int r = SHARD_ID; r < TOTAL_GAMES; r += SHARD_COUNT)
+		if (!completed_rounds.contains(r)) games.push_back(r);
+	return games;
+}
+
+// 比赛流水线：所有轮次的桌都是独立任务，一轮的桌全部打完 (且之前的轮次都已输出) 就输出排名，
+// 不需要等待其他轮次，慢的 bot 不会让其他线程在每轮末尾空等。
+// 同时进行的轮数不超过 rounds.size()，轮次对象循环使用，本桌的交互记录内存也随之复用。
+// 评分按轮次顺序在输出时更新，与总成绩一样只包含已输出的轮次，检查点里的两者一致。
+// 前 k 名的顺序确定后不再开始新的轮次，已经开始的轮次照常打完并输出。
+class RoundPipeline {
+public:
+	std::function<void(Match*)> ready;  // 一桌可以开始了
+	int total = 0;                       // 要打的轮数，提前结束时减少
+	int stopped_at = -1;                 // 提前结束时已经输出的轮数
+	int resumed = 0;                     // 从检查点恢复的已打完轮数
+
+	// games 为要打的轮次 (整场比赛的轮次编号)，依次开始
+	void start(int window, bool exclusive_bots, vector<int> games)
+	{
+		exclusive = exclusive_bots;
+		rounds = vector<Round>(window);
+		for (Round& round : rounds) round.matches = vector<Match>((PLAYER_NUMBER + 2) / 3);
+		seating.resize(bots.size());
+		last.assign(bots.size(), nullptr);
+		schedule = move(games);
+		total = schedule.size();
+		resumed = completed_rounds.size();
+		lock_guard<mutex> guard(lock);
+		while (created < total && created < window) create();
+	}
+
+	// 一桌 (包括 duplicate 模式下的全部座位排列) 打完；全部轮次都输出后返回 true
+	bool finish(Match* match)
+	{
+		lock_guard<mutex> guard(lock);
+		match->done = true;
+		for (int i = 0; i < match->next_count; i++)
+			if (--match->next[i]->waiting == 0) ready(match->next[i]);
+		rounds[match->slot].remaining--;
+		// 按轮次顺序输出
+		while (published < created && rounds[published % rounds.size()].remaining == 0)
+		{
+			Round& round = rounds[published % rounds.size()];
+			trace::Scope scope(trace::PUBLISH, -1, round.matches[0].game_no);
+			scoreboard.merge(published % rounds.size());
+			for (Match& m : round.matches) ratings.update(m.trio, m.trio_score);
+			completed_rounds.insert(round.matches[0].game_no);
+			int done = resumed + published + 1;
+			if (SHARD_COUNT > 1) print_partial(round.matches[0].game_no, done);
+			else print_rank(done - 1);
+			for (Match& m : round.matches)
+				for (int p : m.trio)
+					if (last[p] == &m) last[p] = nullptr;
+			published++;
+			if (stopped_at < 0 && EARLY_STOP_TOP_K > 0 && done >= EARLY_STOP_MIN_GAMES
+				&& ratings.settled(EARLY_STOP_TOP_K, EARLY_STOP_CONFIDENCE / 100.0))
 			{
-				requests2 += ",";
-				requests2 += to_string(*i);
+				stopped_at = done;
+				total = created;
 			}
-			requests2 += "],\"\"\"bid\"\"\":[";
-			requests2 += to_string(player_bid[0]);
-			requests2 += ",";
-			requests2 += to_string(player_bid[1]);
-			requests2 += "]}";
-			responses2 = "";
-			requests[2].push_back(requests2);
-			cmd2 = bots[now+2].first + " \"{\"\"requests\"\"\":[" + requests2 + "],\"\"\"responses\"\"\":[" + responses2 + "]}\"";
-			// cout << "cmd2: " << cmd2 << endl;
-			string response2;
-			response2 = get_response(cmd2.c_str());
-			
-			// cout << "response2: " << response2 << endl;
-			Json::Value input2;
-			reader.parse(response2, input2);
-			player_bid[2] = input2["response"].asInt();
-			responses[2].push_back(to_string(player_bid[2]));
-			//cout << "player_bid[" << bots_no[sub_game][2] << "]: " << player_bid[2] << endl;
-			landlord_position = 0;
-			if (player_bid[1] > player_bid[0])
+			if (checkpointing() && (done % CHECKPOINT_INTERVAL == 0 || published == total))
 			{
-				if (player_bid[2] > player_bid[1])landlord_position = 2;
-				else landlord_position = 1;
+				trace::Scope scope(trace::CHECKPOINT, -1, round.matches[0].game_no);
+				save_checkpoint();
 			}
-			else if (player_bid[2] > player_bid[0])landlord_position = 2;
-			final_bid = *max_element(player_bid, player_bid + 3);
-			//cout << "final_bid: " << final_bid << endl;
-			score = max(final_bid, 1);
-
-			int turn = landlord_position;
-			set<short> history[2];  // history[0]为上上家的出牌记录，history[1]为上家的出牌记录
-			//First round first
+			if (created < total) create();
+		}
+		return published == total;
+	}
+
+	// --game 单独重现一轮时不读写检查点
+	static bool checkpointing() { return !CHECKPOINT_FILE.empty() && ONLY_GAME < 0; }
+
+private:
+	struct Round {
+		Deal deal;
+		vector<Match> matches;
+		int remaining = 0;  // 还没打完的桌数
+	};
+	mutex lock;
+	vector<Round> rounds;
+	int created = 0, published = 0;
+	vector<int> schedule;  // 要打的轮次，第 created 个是下一个开始的
+	vector<int> seating;   // 洗牌后的座位表，第 i 桌坐 seating[3i..3i+2]
+	vector<Match*> last;   // 每个玩家最近加入的一桌
+	bool exclusive = false;
+
+	// 发牌并排好第 created 轮的各桌
+	void create()
+	{
+		int slot = created % rounds.size();
+		Round& round = rounds[slot];
+		int game_no = schedule[created];
+		trace::Scope scope(trace::ROUND_SETUP, -1, game_no);
+		std::mt19937_64 seat_rng = round_rng(game_no, SEATING_STREAM);
+		if (deal_bank.is_open())
+		{
+			const DealRecord& record = deal_bank[game_no];
+			for (int i = 0; i < 3; i++) round.deal.hands[i] = record.hand(i);
+			round.deal.publics = record.publics();
+		}
+		else
+		{
+			std::mt19937_64 deal_rng = round_rng(game_no, DEAL_STREAM);
+			short cards[54];
+			for (short card = 0; card < 54; card++) cards[card] = card;
+			shuffle(cards, cards + 54, deal_rng);
 			for (int i = 0; i < 3; i++)
+				round.deal.hands[i] = CardSet::of(cards + i * 17, cards + (i + 1) * 17);
+			round.deal.publics = CardSet::of(cards + 51, cards + 54);
+		}
+		if (MATCHMAKING == "adaptive") ratings.pair_up(seating, seat_rng);
+		else
+		{
+			// 从固定的顺序洗起，座位只取决于本轮的种子
+			for (size_t i = 0; i < seating.size(); i++) seating[i] = i;
+			shuffle(seating.begin(), seating.end(), seat_rng);
+		}
+
+		round.remaining = round.matches.size();
+		vector<Match*> runnable;
+		for (size_t i = 0; i < round.matches.size(); i++)
+		{
+			Match& match = round.matches[i];
+			for (int j = 0; j < 3; j++) match.trio[j] = seating[i*3+j];
+			match.rotation = 0;
+			match.rotations = DEAL_MODE == "duplicate" ? 6 : 1;
+			match.deal = &round.deal;
+			match.game_no = game_no;
+			match.slot = slot;
+			match.waiting = 0;
+			match.done = false;
+			match.next_count = 0;
+			for (long long& score : match.trio_score) score = 0;
+			match.start();
+			for (int p : match.trio)
 			{
-				string tmp_requests, tmp_responses, tmp_cmd, tmp_response;
-				tmp_requests += "{\"\"\"history\"\"\":[[";
-				if (history[0].size())
-				{
-					tmp_requests += to_string(*history[0].begin());
-					for (set<short>::iterator j = next(history[0].begin()); j != history[0].end(); j++)
-					{
-						tmp_requests += ",";
-						tmp_requests += to_string(*j);
-					}
-				}
-				tmp_requests += "],[";
-				if (history[1].size())
-				{
-					tmp_requests += to_string(*history[1].begin());
-					for (set<short>::iterator j = next(history[1].begin()); j != history[1].end(); j++)
-					{
-						tmp_requests += ",";
-						tmp_requests += to_string(*j);
-					}
-				}
-				tmp_requests += "]],\"\"\"own\"\"\":[";
-				tmp_requests += to_string(*player_cards[turn].begin());
-				for (set<short>::iterator j = next(player_cards[turn].begin()); j != player_cards[turn].end(); j++)
-				{
-					tmp_requests += ",";
-					tmp_requests += to_string(*j);
-				}
-				tmp_requests += "],\"\"\"publiccard\"\"\":[";
-				tmp_requests += to_string(*public_cards.begin());
-				for (set<short>::iterator j = next(public_cards.begin()); j != public_cards.end(); j++)
-				{
-					tmp_requests += ",";
-					tmp_requests += to_string(*j);
-				}
-				tmp_requests += "],\"\"\"landlord\"\"\":";
-				tmp_requests += to_string(landlord_position);
-				tmp_requests += ",\"\"\"pos\"\"\":";
-				tmp_requests += to_string(turn);
-				tmp_requests += ",\"\"\"finalbid\"\"\":";
-				tmp_requests += to_string(final_bid);
-				tmp_requests += "}";
-				requests[turn].push_back(tmp_requests);
-				tmp_cmd += bots[now+turn].first;
-				tmp_cmd += " \"{\"\"requests\"\"\":[";
-				tmp_cmd += requests[turn][0];
-				tmp_cmd += ",";
-				tmp_cmd += requests[turn][1];
-				tmp_cmd += "],\"\"\"responses\"\"\":[";
-				tmp_cmd += *responses[turn].begin();
-				tmp_cmd += "]}\"";
-
-				// cout << "tmp_cmd: " << tmp_cmd << endl;
-				tmp_response = get_response(tmp_cmd.c_str());
-				// cout << "tmp_response: " << tmp_response << endl;
-
-				Json::Value output;
-				Json::Reader reader;
-				reader.parse(tmp_response, output);
-				history[0] = history[1];
-				history[1].clear();
-				for (int j = 0; j < output["response"].size(); j++)history[1].insert(output["response"][j].asInt());
-				if (i == 0)player_cards[landlord_position].insert(public_cards.begin(), public_cards.end());
-				/*cout << bots_no[sub_game][turn] << ": ";
-				print_set(history[1]);*/
-				for (short card : history[1])player_cards[turn].erase(card);
-				if (history[1].size() == 2 && history[1].find(52) != history[1].end() && history[1].find(53) != history[1].end())score *= 2;  // 王炸
-				else if (history[1].size() == 4 && *history[1].begin() == *prev(history[1].end()))score *= 2;  // 炸弹
-				tmp_responses.clear();
-				tmp_responses += "[";
-				if (history[1].size())
+				if (exclusive && last[p] && !last[p]->done)
 				{
-					tmp_responses += to_string(*history[1].begin());
-					for (set<short>::iterator j = next(history[1].begin()); j != history[1].end(); j++)
-					{
-						tmp_responses += ",";
-						tmp_responses += to_string(*j);
-					}
+					last[p]->next[last[p]->next_count++] = &match;
+					match.waiting++;
 				}
-				tmp_responses += "]";
-				responses[turn].push_back(tmp_responses);
-				turn = (turn + 1) % 3;
+				last[p] = &match;
 			}
-			//And then next turns ...
-			bool landlord_has_not_played = true;
-			while (true)
-			{
-				string tmp_requests, tmp_responses, tmp_cmd, tmp_response;
-				tmp_requests += "{\"\"\"history\"\"\":[[";
-				if (history[0].size())
-				{
-					tmp_requests += to_string(*history[0].begin());
-					for (set<short>::iterator j = next(history[0].begin()); j != history[0].end(); j++)
-					{
-						tmp_requests += ",";
-						tmp_requests += to_string(*j);
-					}
-				}
-				tmp_requests += "],[";
-				if (history[1].size())
-				{
-					tmp_requests += to_string(*history[1].begin());
-					for (set<short>::iterator j = next(history[1].begin()); j != history[1].end(); j++)
-					{
-						tmp_requests += ",";
-						tmp_requests += to_string(*j);
-					}
-				}
-				tmp_requests += "]]}";
-				requests[turn].push_back(tmp_requests);
-				tmp_cmd += bots[now+turn].first;
-				tmp_cmd += " \"{\"\"requests\"\"\":[";
-				tmp_cmd += *requests[turn].begin();
-				for (vector<string>::iterator i = next(requests[turn].begin()); i != requests[turn].end(); i++)
-				{
-					tmp_cmd += ",";
-					tmp_cmd += *i;
-				}
-				tmp_cmd += "],\"\"\"responses\"\"\":[";
-				tmp_cmd += *responses[turn].begin();
-				for (vector<string>::iterator i = next(responses[turn].begin()); i != responses[turn].end(); i++)
-				{
-					tmp_cmd += ",";
-					tmp_cmd += *i;
-				}
-				tmp_cmd += "]}\"";
-				Json::Value output;
-				Json::Reader reader;
-
-				// cout << "tmp_cmd: " << tmp_cmd << endl;
-				tmp_response = get_response(tmp_cmd.c_str());
-				// cout << "tmp_response: " << tmp_response << endl;	
-				
-				reader.parse(tmp_response, output);
-				//cout << "tmp_cmd: " << tmp_cmd << endl;
-				history[0] = history[1];
-				history[1].clear();
-				for (int i = 0; i < output["response"].size(); i++)history[1].insert(output["response"][i].asInt());
-				/*cout << bots_no[sub_game][turn] << ": ";
-				print_set(history[1]);*/
-				for (short card : history[1])player_cards[turn].erase(card);
-				if (history[1].size() == 2 && history[1].find(52) != history[1].end() && history[1].find(53) != history[1].end())score *= 2;  // 王炸
-				else if (history[1].size() == 4 && *history[1].begin() == *prev(history[1].end()))score *= 2;  // 炸弹
-				if (turn == landlord_position && history[1].size())landlord_has_not_played = false;  // 地主除了第一手之外出过牌了
-				tmp_responses.clear();
-				tmp_responses += "[";
-				if (history[1].size())
-				{
-					tmp_responses += to_string(*history[1].begin());
-					for (set<short>::iterator j = next(history[1].begin()); j != history[1].end(); j++)
-					{
-						tmp_responses += ",";
-						tmp_responses += to_string(*j);
-					}
-				}
-				tmp_responses += "]";
-				responses[turn].push_back(tmp_responses);
+			if (match.waiting == 0) runnable.push_back(&match);
+		}
+		created++;
+		for (Match* match : runnable) ready(match);
+	}
+};
 
-				if (!player_cards[turn].size())
-				{
-					if (turn == landlord_position)  //landlord win
-					{
-						if (player_cards[(turn+1)%3].size()==17 && player_cards[(turn+2)%3].size()==17)score*=2;  // 地主春天				
-                        // cout << "landlord is " << bots[now+turn].first << '\n';
-                        Final_score[bots[now+turn].first].round[game_no] ++;
-                        Final_score[bots[now+turn].first].score[game_no] += 2*score;
-                        player_winning_rounds[bots[now+turn].second]++;
-                        player_winning_scores[bots[now+turn].second]+=2*score;
-						for (int i=0; i<3; i++)
-							if (i != turn) 
-                            {   
-                                Final_score[bots[now+i].first].score[game_no] -= score;
-                                player_winning_scores[bots[now+i].second] -= score;
-                            }
-					}
-					else  // 农民胜利
-					{
-						if (landlord_has_not_played) score *= 2;  // 农民春天		
-                        Final_score[bots[now+landlord_position].first].score[game_no] -= 2*score;
-                        player_winning_scores[bots[now+landlord_position].second] -= 2*score;
-						for(int i=0; i<3; i++)
-						{
-							if(i != landlord_position) Final_score[bots[now+i].first].score[game_no] += score;
-							if(i != landlord_position) Final_score[bots[now+i].first].round[game_no]++;
-							if(i != landlord_position) player_winning_scores[bots[now+i].second] += score;
-							if(i != landlord_position) player_winning_rounds[bots[now+i].second] ++;
-						}
-					}
+int main(int argc, char* argv[])
+{
+	#ifdef _WIN32
+    SetConsoleOutputCP(65001); 
+    #endif
+    // 加载配置
+    if (!load_config(argc, argv)) {
+        cerr << "Failed to load configuration" << endl;
+        return 1;
+    }
 
+    // 同时进行的轮数：默认让每个线程大约有两桌可做
+    int threads = 1;
 #ifdef PARALLEL
-					// #pragma omp critical
-					// {
-					// 	cout << "thread is " << omp_get_thread_num() << ", game " << game_no << " is "; 
-					// 	cout << "over, winner: " << bots[now+turn].first;
-					// 	if (turn != landlord_position) cout << ", " << bots[now+3-turn-landlord_position].first;
-					// 	cout << "; landlord: " << bots[now+landlord_position].first;
-					// 	cout << "; score: " << score << endl;
-					// }
-					// printf("thread id = %d game %d round %d, winner is %d, score is %d\n", omp_get_thread_num(),game_no,sub_game,bots_no[sub_game][turn],score);
+    threads = omp_get_max_threads();
 #endif
-#ifndef PARALLEL
-					cout << "game " << game_no << " is "; 
-					cout << "over, winner: " << bots[now+turn].first;
-					if (turn != landlord_position)cout << ", " << bots[now+3-turn-landlord_position].first;
-					cout << "; landlord: " << bots[now+landlord_position].first;
-					cout << "; score: " << score << endl;
+    // 成绩表和评分先按玩家数初始化，再从检查点恢复
+    completed_rounds.init(TOTAL_GAMES);
+    ratings.init(bots.size());
+    scoreboard.init(bots.size(), 1);
+    if (RoundPipeline::checkpointing() && !load_checkpoint()) return 1;
+    if (ONLY_GAME >= 0 && MATCHMAKING == "adaptive")
+        cerr << "Warning: adaptive seating depends on earlier rounds, --game reproduces only the deal" << endl;
+    vector<int> games = pending_rounds();
+    if (completed_rounds.size() > 0)
+        cerr << "Resumed from checkpoint " << CHECKPOINT_FILE << ": " << completed_rounds.size() << " rounds done, "
+             << games.size() << " to play" << endl;
+
+    int tables = (PLAYER_NUMBER + 2) / 3;
+    int window = MAX_INFLIGHT_ROUNDS > 0 ? MAX_INFLIGHT_ROUNDS : max(2, (2 * threads + tables - 1) / tables);
+    window = min(window, max((int)games.size(), 1));
+
+    if (!REPLAY_DIR.empty())
+    {
+        error_code ec;
+        fs::create_directories(REPLAY_DIR, ec);
+        replays = vector<ReplayWriter>(threads);
+        for (int i = 0; i < threads; i++)
+        {
+            string path = REPLAY_DIR + "/worker" + to_string(i) + ".bfr";
+            if (!replays[i].open(path))
+            {
+                cerr << "Error: cannot open replay file " << path << endl;
+                return 1;
+            }
+        }
+    }
+
+    // 同一个可执行文件的各玩家共用缓存条目
+    cache_seed.assign(bots.size(), 0);
+    if (!deterministic_bots.empty() && DECISION_CACHE_SIZE > 0)
+    {
+        decision_cache.init(DECISION_CACHE_SIZE);
+        for (size_t i = 0; i < bots.size(); i++)
+            if (!plugins[i] && deterministic_bots.count(fs::path(bots[i].first).stem().string()))
+                cache_seed[i] = hash_bytes(bots[i].first) | 1;
+    }
+
+    // 只有单次启动的可执行文件能推测执行；没有这样的玩家时预算为 0，不再尝试
+    speculative.assign(bots.size(), 0);
+    bool speculating = false;
+    for (size_t i = 0; i < bots.size(); i++)
+        if (!plugins[i] && !keep_running_enabled(i) && speculative_bots.count(fs::path(bots[i].first).stem().string()))
+            speculative[i] = speculating = true;
+    if (!speculating) SPECULATION_BUDGET = 0;
+    else if (SPECULATION_BUDGET == 0) SPECULATION_BUDGET = max(1u, thread::hardware_concurrency());
+
+    // 单次启动的可执行文件预先启动空闲进程 (插件和常驻进程不需要)
+    if (PRESPAWN > 0)
+    {
+        vector<string> exes(bots.size());
+        for (size_t i = 0; i < bots.size(); i++)
+            if (!plugins[i] && !keep_running_enabled(i)) exes[i] = bots[i].first;
+        prespawn_pool.start(exes, PRESPAWN);
+    }
+
+#ifndef BATTLEFIELD_NO_TRACE
+    if (!TRACE_FILE.empty()) trace::tracer.start(bots.size(), TRACE_BUFFER);
 #endif
-					break;
-				}
-				turn = (turn + 1) % 3;
-			}
-		}
-        print_rank(game_no);
+
+    // 每个进行中的轮次一份成绩增量
+    scoreboard.resize(window);
+    bot_processes = vector<BotProcess>(bots.size());
+#ifndef _WIN32
+    // bot 提前退出时写管道不应终止引擎
+    signal(SIGPIPE, SIG_IGN);
+    scheduler.launch = launch_decision;
+    scheduler.complete = complete_decision;
+    scheduler.limits = LIMITS;
+    scheduler.max_inflight = MAX_INFLIGHT_TABLES;
+#endif
+
+    // cout << colors[0] << "(test)" << "\033[0m" << '\n';
+	// freopen("result.txt","w",stdout);
+	if (UPLINK == "websocket")
+	{
+		// 分片运行时后端按 worker 参数区分各分片的连接
+		string url = BACKEND_URL;
+		if (SHARD_COUNT > 1) url += (url.find('?') == string::npos ? "?" : "&") + string("worker=") + to_string(SHARD_ID);
+		if (!uplink.start(url, UPLINK_INTERVAL_MS))
+			cerr << "Warning: cannot connect to " << url << " (" << uplink.error() << "), writing JSON_DATA to stdout" << endl;
 	}
+	print_init();
+	auto start = std::chrono::high_resolution_clock::now();
+	RoundPipeline pipeline;
+#ifndef _WIN32
+	if (SCHEDULER == "epoll")
+	{
+		deque<Match*> runnable;
+		pipeline.ready = [&runnable](Match* match) { runnable.push_back(match); };
+		pipeline.start(window, ONE_GAME_PER_BOT == "on", games);
+		scheduler.finish = [&pipeline](Match& match) {
+			settle(match);
+			if (match.next_rotation()) return true;
+			// 之后 match 可能被下一轮复用，由 run 重新取出
+			pipeline.finish(&match);
+			return false;
+		};
+		scheduler.run([&runnable]() -> Match* {
+			if (runnable.empty()) return nullptr;
+			Match* match = runnable.front();
+			runnable.pop_front();
+			return match;
+		});
+	}
+	else
+#endif
+	{
+		WorkStealingPool<Match> pool(threads);
+		pipeline.ready = [&pool](Match* match) { pool.push(omp_get_thread_num(), match); };
+		pipeline.start(window, ONE_GAME_PER_BOT == "on", games);
+		if (pipeline.total <= 0) pool.close();
 #ifdef PARALLEL
-	#pragma omp barrier
-	#pragma omp single
+		#pragma omp parallel
 #endif
-    sort(bots.begin(), bots.end(), [](const pair<string,string>& a, const pair<string,string>& b){
-            return player_winning_scores[a.second]>player_winning_scores[b.second];});
+		{
+			int worker = omp_get_thread_num();
+			while (Match* match = pool.pop(worker))
+			{
+				Table& t = match->table;
+				do {
+					while (!t.finished()) play_turn(*match);
+					settle(*match);
+				} while (match->next_rotation());
+				if (pipeline.finish(match)) pool.close();
+			}
+		}
+	}
+	for (ReplayWriter& replay : replays) replay.close();
+	long long prespawn_hits = prespawn_pool.hits(), prespawn_misses = prespawn_pool.misses();
+	prespawn_pool.close();
+	bool uplinked = uplink.running();
+	uplink.close();
+	if (pipeline.stopped_at >= 0)
+		cout << "Early stop: top " << EARLY_STOP_TOP_K << " settled after " << pipeline.stopped_at
+		     << " games, played " << pipeline.total << " of " << TOTAL_GAMES << "\n";
 	cout << "result: " << '\n';
-    for(int player=0; player<PLAYER_NUMBER; player++)
+    for(int player : standings())
     {
-        string name=bots[player].second;
-        cout << name << ", win_rounds = " << player_winning_rounds[name] << ", win_scores = " << player_winning_scores[name] << '\n';
+        const PlayerScore& ps = scoreboard[player];
+        cout << bots[player].second << ", win_rounds = " << ps.wins << ", win_scores = " << ps.score
+             << ", forfeits = " << ps.forfeits << ", timeouts = " << ps.timeouts
+             << ", p50 = " << ps.latency.quantile(0.5) << " ms, p99 = " << ps.latency.quantile(0.99) << " ms"
+             << ", cpu = " << (long long)ps.cpu_ms << " ms, peak_rss = " << ps.peak_rss_kb << " KB"
+             << ", rating = " << (long long)ratings.rating(player) << " +- " << (long long)ratings.interval(player);
+        if (ENDGAME_CARDS > 0) cout << ", endgame blunders = " << ps.endgame_blunders << "/" << ps.endgame_decisions;
+        cout << "\n";
     }
+    if (decision_cache.enabled())
+    {
+        long long hits = decision_cache.hits(), lookups = hits + decision_cache.misses();
+        cout << "Decision cache: hits = " << hits << ", misses = " << lookups - hits
+             << ", hit rate = " << fixed << setprecision(1) << (lookups ? 100.0 * hits / lookups : 0.0) << "%\n"
+             << defaultfloat;
+    }
+    if (trace::tracer.enabled())
+    {
+        vector<string> names;
+        for (const auto& bot : bots) names.push_back(bot.second);
+        if (!trace::tracer.write_chrome(TRACE_FILE, names)) cerr << "Error: cannot write trace " << TRACE_FILE << endl;
+        trace::tracer.print_summary(cout, names);
+    }
+    if (uplinked)
+        cout << "Uplink: sent = " << uplink.sent() << ", coalesced = " << uplink.coalesced() << "\n";
+    if (SPECULATION_BUDGET > 0)
+        cout << "Speculation: launched = " << speculation_launched << ", used = " << speculation_used
+             << ", cancelled = " << speculation_cancelled << "\n";
+    if (PRESPAWN > 0)
+        cout << "Prespawn: hits = " << prespawn_hits << ", misses = " << prespawn_misses << "\n";
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    cout << "Seed: " << SEED << "\n";
     cout << "Elapsed time: " << duration << " ms\n";
+#ifdef BATTLEFIELD_COUNT_ALLOCS
+    cout << "Allocations: " << allocation_count.load() << "\n";
+#endif
 }
\ No newline at end of file
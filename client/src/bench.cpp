@@ -0,0 +1,356 @@
+//Chinese UTF-8
+// 引擎自身开销的基准测试: make bench
+// 分阶段: 发牌、请求构建 (交互记录 + 合法性检查)、输出解析 (引擎的解析器和 jsoncpp 对照)、计分，各自的单次耗时和分配次数；
+// 整局: 内置参考 bot (进程内) 和 stub 可执行文件 (每次决策启动一次) 各打若干局，给出每秒局数、每局分配次数和各阶段耗时占比；
+// 整场比赛: 用带分配计数的引擎 (main_bench) 在临时目录中按两种 bot 各跑一场。
+// 用法: bench [main_bench] [bench_stub]，不给出时跳过对应的部分。
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+#include "jsoncpp/json.h"
+#include "alloc_counter.h"
+#include "table.h"
+#include "scoreboard.h"
+#include "bot_process.h"
+#include "plugin.h"
+#include "reference_bot.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double ms_since(Clock::time_point t) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+struct Result {
+    long long ops = 0;
+    double ns = 0;      // 每次耗时
+    double allocs = 0;  // 每次分配次数
+};
+
+// 重复 op 直到用完 budget_ms (至少一次)
+template <class Op>
+Result measure(double budget_ms, Op&& op) {
+    Result r;
+    long long allocs = allocation_count;
+    auto began = Clock::now();
+    double elapsed = 0;
+    for (long long batch = 1; elapsed < budget_ms; batch = min(batch * 2, 1LL << 16)) {
+        for (long long i = 0; i < batch; i++) op();
+        r.ops += batch;
+        elapsed = ms_since(began);
+    }
+    r.ns = elapsed * 1e6 / r.ops;
+    r.allocs = (double)(allocation_count - allocs) / r.ops;
+    return r;
+}
+
+static void print_result(const string& name, const Result& r, const string& unit) {
+    cout << left << setw(28) << name << right << setw(12) << fixed << setprecision(1) << r.ns << " ns/" << unit
+         << setw(10) << setprecision(2) << r.allocs << " allocs/" << unit << "  (" << r.ops << " " << unit << "s)\n";
+}
+
+struct Deal {
+    CardSet hands[3];
+    CardSet publics;
+};
+
+static void deal(std::mt19937_64& rng, short cards[54], Deal& d) {
+    shuffle(cards, cards + 54, rng);
+    for (int i = 0; i < 3; i++) d.hands[i] = CardSet::of(cards + i * 17, cards + (i + 1) * 17);
+    d.publics = CardSet::of(cards + 51, cards + 54);
+}
+
+// 各阶段的累计耗时 (毫秒)
+struct Phases {
+    double deal = 0;
+    double bot = 0;      // bot 的决策，stub 包括启动进程和读取输出
+    double engine = 0;   // 请求构建、解析输出、合法性检查
+    double scoring = 0;
+};
+
+// 反复打一局: 三个座位都是内置参考 bot，stub 非空时改为每次决策启动一次 stub
+class GameRunner {
+public:
+    Phases phases;
+    long long decisions = 0;
+    vector<uint64_t> moves;  // 最近一局的全部决策 (叫分或出牌掩码)，按决策顺序
+    Deal last_deal;
+
+    explicit GameRunner(string stub_path = "") : stub(move(stub_path)), rng(20240601) {
+        for (short c = 0; c < 54; c++) cards[c] = c;
+        for (int i = 0; i < 3; i++) {
+            natives[i].bind(reference_plugin());
+            table.native[i] = stub.empty();
+        }
+        board.init(3, 1);
+    }
+
+    void play() {
+        auto t0 = Clock::now();
+        deal(rng, cards, last_deal);
+        auto t1 = Clock::now();
+        table.start(last_deal.hands, last_deal.publics);
+        phases.deal += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        phases.engine += ms_since(t1);
+        moves.clear();
+        while (!table.finished()) {
+            stub.empty() ? native_turn() : stub_turn();
+            decisions++;
+        }
+        auto t2 = Clock::now();
+        for (int i = 0; i < 3; i++) {
+            PlayerScore& ps = board.local(0, i);
+            ps.score += table.delta(i);
+            if (table.won(i)) ps.wins++;
+        }
+        if (++games % 4 == 0) {
+            board.merge(0);
+            board.ranking();
+        }
+        phases.scoring += ms_since(t2);
+        if (table.forfeit >= 0) forfeits++;
+    }
+
+    int forfeit_count() const { return forfeits; }
+
+private:
+    Table table;
+    NativeBot natives[3];
+    BotProcess procs[3];
+    string stub;
+    std::mt19937_64 rng;
+    short cards[54];
+    Scoreboard board;
+    long long games = 0;
+    int forfeits = 0;
+
+    void native_turn() {
+        int seat = table.turn;
+        auto t0 = Clock::now();
+        uint64_t move = table.phase == Table::BIDDING ? natives[seat].bid(table.bid_request())
+                                                      : natives[seat].play(table.play_request());
+        auto t1 = Clock::now();
+        PlayerScore& ps = board.local(0, seat);
+        double wall = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        moves.push_back(move);
+        if (table.phase == Table::BIDDING) table.feed_bid((int)move);
+        else table.feed_play(CardSet(move));
+        auto t2 = Clock::now();
+        ps.record(wall, wall, 0, false);
+        phases.bot += wall;
+        phases.engine += std::chrono::duration<double, std::milli>(t2 - t1).count();
+        phases.scoring += ms_since(t2);
+    }
+
+    void stub_turn() {
+        int seat = table.turn;
+        BotProcess& proc = procs[seat];
+        string output;
+        auto t0 = Clock::now();
+        proc.begin_decision();
+        if (proc.start(stub, table.transcript[seat].input().data())) {
+            proc.close_input();
+            proc.await(output, true, Limits());
+        }
+        Usage usage = proc.usage();
+        proc.stop();
+        auto t1 = Clock::now();
+        table.feed(output);
+        auto t2 = Clock::now();
+        board.local(0, seat).record(usage.wall_ms, usage.cpu_ms, usage.peak_rss_kb, false);
+        phases.bot += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        phases.engine += std::chrono::duration<double, std::milli>(t2 - t1).count();
+        phases.scoring += ms_since(t2);
+    }
+};
+
+static void print_games(const string& name, GameRunner& runner, double budget_ms) {
+    Result r = measure(budget_ms, [&runner] { runner.play(); });
+    double total = r.ns * r.ops / 1e6;
+    const Phases& p = runner.phases;
+    double sum = p.deal + p.bot + p.engine + p.scoring;
+    auto share = [sum](double v) { return sum > 0 ? 100 * v / sum : 0.0; };
+    cout << left << setw(28) << name << right << fixed << setprecision(1)
+         << setw(12) << r.ops * 1000.0 / total << " games/s" << setw(10) << setprecision(2) << r.allocs << " allocs/game"
+         << "  (" << r.ops << " games, " << setprecision(1) << (double)runner.decisions / r.ops << " decisions/game, "
+         << runner.forfeit_count() << " forfeits)\n"
+         << "    split: deal " << share(p.deal) << "%, bot " << share(p.bot) << "%, engine " << share(p.engine)
+         << "%, scoring " << share(p.scoring) << "%\n";
+}
+
+// 在临时目录中跑一场比赛，返回是否成功
+static bool run_tournament(const string& name, const fs::path& engine, const fs::path& stub, const string& config) {
+    fs::path dir = fs::temp_directory_path() / ("botfield_bench_" + name);
+    error_code ec;
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir / "bots");
+    if (!stub.empty()) {
+        // 引擎按 bot_dir 下的 stub.exe 识别出 default_bot，再以不带后缀的路径启动
+        fs::copy_file(stub, dir / "bots" / "stub.exe");
+#ifndef _WIN32
+        fs::copy_file(stub, dir / "bots" / "stub");
+#endif
+    }
+    ofstream(dir / "config.yaml") << config;
+    fs::path cwd = fs::current_path();
+    fs::current_path(dir);
+    string cmd = "\"" + engine.string() + "\" > out.txt 2> err.txt";
+    int status = system(cmd.c_str());
+    fs::current_path(cwd);
+
+    ifstream out(dir / "out.txt"), err(dir / "err.txt");
+    long long elapsed = -1, allocs = -1;
+    int forfeits = 0;
+    for (string line; getline(out, line);) {
+        if (line.rfind("Elapsed time: ", 0) == 0) elapsed = atoll(line.c_str() + 14);
+        if (line.rfind("Allocations: ", 0) == 0) allocs = atoll(line.c_str() + 13);
+    }
+    for (string line; getline(err, line);) forfeits += line.rfind("Forfeit:", 0) == 0;
+    if (status != 0 || elapsed < 0) {
+        cout << left << setw(28) << name << "failed, see " << dir.string() << "\n";
+        return false;
+    }
+    fs::remove_all(dir, ec);
+
+    // 配置里固定 12 个玩家，每轮 4 桌
+    int rounds = 0;
+    istringstream(config.substr(config.find("total_games:") + 12)) >> rounds;
+    long long games = rounds * 4LL;
+    cout << left << setw(28) << name << right << fixed << setprecision(1)
+         << setw(12) << games * 1000.0 / max(elapsed, 1LL) << " games/s" << setw(10) << setprecision(2)
+         << (double)allocs / games << " allocs/game  (" << games << " games in " << elapsed << " ms, "
+         << forfeits << " forfeits)\n";
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    fs::path engine = argc > 1 ? fs::absolute(argv[1]) : fs::path();
+    fs::path stub = argc > 2 ? fs::absolute(argv[2]) : fs::path();
+#ifdef _WIN32
+    if (!engine.empty() && !fs::exists(engine)) engine += ".exe";
+    if (!stub.empty() && !fs::exists(stub)) stub += ".exe";
+#endif
+    cout << "== phases\n";
+    {
+        std::mt19937_64 rng(1);
+        short cards[54];
+        for (short c = 0; c < 54; c++) cards[c] = c;
+        Deal d;
+        print_result("deal", measure(300, [&] { deal(rng, cards, d); }), "deal");
+    }
+
+    // 先用参考 bot 打一局，之后按同样的决策重放
+    GameRunner sample;
+    do sample.play(); while (sample.moves.size() < 30);
+    const vector<uint64_t> moves = sample.moves;
+    const Deal game = sample.last_deal;
+    vector<string> outputs;
+    for (size_t i = 0; i < moves.size(); i++) {
+        ostringstream s;
+        if (i < 3) s << "{\"response\":" << moves[i] << "}";
+        else {
+            s << "{\"response\":[";
+            bool comma = false;
+            for (short card : CardSet(moves[i])) s << (comma ? "," : "") << card, comma = true;
+            s << "],\"debug\":\"greedy\"}";
+        }
+        outputs.push_back(s.str());
+    }
+
+    {
+        Table table;
+        Result r = measure(300, [&] {
+            table.start(game.hands, game.publics);
+            for (size_t i = 0; i < moves.size(); i++) {
+                if (i < 3) table.feed_bid((int)moves[i]);
+                else table.feed_play(CardSet(moves[i]));
+            }
+        });
+        r.ns /= moves.size();
+        r.allocs /= moves.size();
+        print_result("request build + check", r, "decision");
+    }
+    {
+        size_t i = 0;
+        long long sink = 0;
+        Result r = measure(300, [&] {
+            // 与 Table::feed 相同的解析方式
+            Response response;
+            ResponseParser::parse(outputs[i], response);
+            sink += response.number + response.cards.size();
+            i = (i + 1) % outputs.size();
+        });
+        print_result("response parse", r, "decision");
+        if (sink < 0) cout << sink;
+    }
+    {
+        size_t i = 0;
+        long long sink = 0;
+        Result r = measure(300, [&] {
+            // 对照: 改用解析器之前的方式
+            Json::Reader reader;
+            Json::Value input;
+            reader.parse(outputs[i], input);
+            const Json::Value& response = input["response"];
+            if (response.isInt()) sink += response.asInt();
+            else for (unsigned j = 0; j < response.size(); j++) sink += response[j].asInt();
+            i = (i + 1) % outputs.size();
+        });
+        print_result("response parse (jsoncpp)", r, "decision");
+        if (sink < 0) cout << sink;
+    }
+    {
+        Scoreboard board;
+        board.init(12, 1);
+        Table table;
+        table.start(game.hands, game.publics);
+        for (size_t i = 0; i < moves.size(); i++) {
+            if (i < 3) table.feed_bid((int)moves[i]);
+            else table.feed_play(CardSet(moves[i]));
+        }
+        long long n = 0;
+        Result r = measure(300, [&] {
+            for (int i = 0; i < 3; i++) {
+                PlayerScore& ps = board.local(0, (n + i) % 12);
+                ps.score += table.delta(i);
+                if (table.won(i)) ps.wins++;
+                ps.record(1.0, 1.0, 1024, false);
+            }
+            if (++n % 4 == 0) {
+                board.merge(0);
+                board.ranking();
+            }
+        });
+        print_result("scoring", r, "game");
+    }
+
+    cout << "== full game\n";
+    GameRunner native;
+    print_games("game (builtin greedy)", native, 1000);
+    if (!stub.empty()) {
+        GameRunner process(stub.string());
+        print_games("game (stub exe)", process, 3000);
+    }
+
+    if (!engine.empty()) {
+        cout << "== tournament (12 players, 4 tables per round)\n";
+        string common = "player_number: 12\nbot_dir: bots\ndeal_mode: single\n";
+        run_tournament("builtin", engine, "", common + "total_games: 500\ndefault_bot: " + REFERENCE_BOT + "\n");
+        if (!stub.empty()) {
+            run_tournament("stub", engine, stub, common + "total_games: 10\ndefault_bot: stub\n");
+            run_tournament("stub (prespawn)", engine, stub, common + "total_games: 10\ndefault_bot: stub\nbot_input: stdin\nprespawn: 4\n");
+        }
+    }
+    return 0;
+}
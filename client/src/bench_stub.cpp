@@ -0,0 +1,67 @@
+// 基准测试用的 bot 可执行文件：打法与内置参考 bot 相同，按 Botzone 单次启动协议交互
+// 输入为完整的交互记录 (唯一的命令行参数，没有参数时读标准输入)，输出一行 {"response":...}
+// 用来和进程内的参考 bot 对比，得出启动进程、管道和 JSON 的开销。
+
+#include <iostream>
+#include <iterator>
+#include <string>
+#include "jsoncpp/json.h"
+#include "reference_bot.h"
+
+static CardSet cards_of(const Json::Value& list) {
+    CardSet s;
+    for (const Json::Value& card : list) s.insert(card.asInt());
+    return s;
+}
+
+int main(int argc, char* argv[]) {
+    std::string text;
+    if (argc > 1) text = argv[1];
+    else text.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    Json::Value input;
+    Json::Reader reader;
+    if (!reader.parse(text, input)) return 1;
+    const Json::Value& requests = input["requests"];
+    const Json::Value& responses = input["responses"];
+    unsigned n = requests.size();
+
+    if (n == 1) {
+        const Json::Value& req = requests[0u];
+        int32_t bids[3] = {};
+        int count = 0;
+        for (const Json::Value& b : req["bid"]) if (count < 3) bids[count++] = b.asInt();
+        std::cout << "{\"response\":" << reference_bot::bid(cards_of(req["own"]), bids, count) << "}" << std::endl;
+        return 0;
+    }
+
+    // requests[1] 是第一次出牌的请求，带有手牌和座位信息；之后只有最近两手出牌
+    const Json::Value& first = requests[1u];
+    bf_play_request req = {};
+    req.pos = first["pos"].asInt();
+    req.landlord = first["landlord"].asInt();
+    req.final_bid = first["finalbid"].asInt();
+    req.publics = cards_of(first["publiccard"]).mask();
+    CardSet own = cards_of(first["own"]);
+    if (req.pos == req.landlord) own.insert(CardSet(req.publics));  // own 不含底牌
+    for (unsigned i = 1; i + 1 < n && i < responses.size(); i++) own.erase(cards_of(responses[i]));
+    for (int i = 0; i < 3; i++) req.remaining[i] = i == req.landlord ? 20 : 17;
+    for (unsigned i = 1; i < n; i++) {
+        const Json::Value& history = requests[i]["history"];
+        req.remaining[(req.pos + 1) % 3] -= cards_of(history[0u]).size();
+        req.remaining[(req.pos + 2) % 3] -= cards_of(history[1u]).size();
+    }
+    req.remaining[req.pos] = own.size();
+    const Json::Value& last = requests[n - 1]["history"];
+    req.history[0] = cards_of(last[0u]).mask();
+    req.history[1] = cards_of(last[1u]).mask();
+    req.own = own.mask();
+
+    std::cout << "{\"response\":[";
+    bool comma = false;
+    for (short card : CardSet(reference_bot::play(req))) {
+        std::cout << (comma ? "," : "") << card;
+        comma = true;
+    }
+    std::cout << "]}" << std::endl;
+    return 0;
+}
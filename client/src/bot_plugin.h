@@ -0,0 +1,54 @@
+#ifndef BOT_PLUGIN_H
+#define BOT_PLUGIN_H
+
+/* 进程内 bot 插件的 C ABI (版本 BOTFIELD_ABI_VERSION)
+ * 插件是放在 bot_dir 下的共享库 (.so / .dll)，导出一个函数:
+ *     const bf_plugin* botfield_plugin(void);
+ * 引擎在工作线程上直接调用其中的函数，不经过进程、管道和 JSON。
+ * 牌用 64 位掩码表示：第 card 位为 1 表示持有 card 号牌 (编号同 Botzone: 0..51 每 4 张一个点数, 52 小王, 53 大王)。
+ * 每个座位一个 bot 实例 (init 创建)，同一实例同一时间只会被一个线程调用，不同实例可能被并发调用。
+ */
+
+#include <stdint.h>
+
+#define BOTFIELD_ABI_VERSION 1
+
+#ifdef _WIN32
+#define BOTFIELD_EXPORT __declspec(dllexport)
+#else
+#define BOTFIELD_EXPORT __attribute__((visibility("default")))
+#endif
+
+typedef struct bf_bid_request {
+    uint64_t own;        /* 手牌 */
+    int32_t pos;         /* 自己的座位 0..2 */
+    int32_t bid_count;   /* 之前座位的叫分个数，即 pos */
+    int32_t bids[3];     /* 之前座位的叫分 */
+} bf_bid_request;
+
+typedef struct bf_play_request {
+    uint64_t own;          /* 当前手牌 (地主的第一手已包含底牌) */
+    uint64_t publics;      /* 底牌 */
+    uint64_t history[2];   /* history[0] 上上家的出牌，history[1] 上家的出牌，过牌为 0 */
+    const uint64_t* plays; /* 本局到目前为止的全部出牌，从地主开始按座位轮流，过牌为 0 */
+    int32_t play_count;
+    int32_t pos;           /* 自己的座位 */
+    int32_t landlord;      /* 地主的座位 */
+    int32_t final_bid;     /* 地主的叫分 */
+    int32_t remaining[3];  /* 各座位剩余的张数 */
+} bf_play_request;
+
+typedef struct bf_plugin {
+    uint32_t abi_version;  /* 必须为 BOTFIELD_ABI_VERSION */
+    const char* name;
+    void* (*init)(void);                                     /* 创建一个 bot 实例 */
+    void (*reset)(void* bot);                                /* 新的一局开始 */
+    int32_t (*bid)(void* bot, const bf_bid_request* req);    /* 叫分 0..3 */
+    uint64_t (*play)(void* bot, const bf_play_request* req); /* 出牌掩码，0 为过 */
+    void (*destroy)(void* bot);
+} bf_plugin;
+
+#define BOTFIELD_PLUGIN_ENTRY "botfield_plugin"
+typedef const bf_plugin* (*bf_plugin_entry)(void);
+
+#endif /* BOT_PLUGIN_H */
@@ -0,0 +1,465 @@
+#ifndef BOT_PROCESS_H
+#define BOT_PROCESS_H
+
+// bot 进程，通过管道连接 stdin/stdout，不经过 shell
+// POSIX 上用 posix_spawn 启动 (glibc 中为 CLONE_VFORK，不复制引擎的页表)，参数直接作为 argv 传入，不需要转义
+// 单次启动：输入作为唯一的命令行参数或写入 stdin，读取全部输出直到进程关闭 stdout
+// 常驻 (类似 Botzone 的长时运行模式)：进程只启动一次，之后按行交互
+//   - 每局第一次决策写入完整的 {"requests":[...],"responses":[...]}
+//   - 之后只写入最新的一条 request
+//   - bot 每次输出一行 response，可以再跟一行 >>>BOTZONE_REQUEST_KEEP_RUNNING<<<
+// 每次决策可以限制墙钟时间和 CPU 时间，超限时结束进程。
+// 资源占用：单次启动的进程由 wait4 的 rusage 给出 CPU 时间和峰值内存；
+// 常驻进程不会在决策之间退出，CPU 时间取自进程的 CPU 时钟，峰值内存取自 /proc/<pid>/status 的 VmHWM。
+
+#include <string>
+#include <string_view>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdint>
+#ifdef _WIN32
+#include <windows.h>
+#define PSAPI_VERSION 2
+#include <psapi.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <spawn.h>
+#include <fstream>
+extern char** environ;
+#endif
+
+const std::string KEEP_RUNNING_MARK = ">>>BOTZONE_REQUEST_KEEP_RUNNING<<<";
+
+// 每次决策的限制，0 表示不限制
+struct Limits {
+    int wall_ms = 0;  // 墙钟时间，从启动进程或写入请求开始计算
+    int cpu_ms = 0;   // CPU 时间 (用户态 + 内核态)
+
+    // 超限时返回原因
+    const char* exceeded(double wall, double cpu) const {
+        if (cpu_ms > 0 && cpu > cpu_ms) return "cpu time limit exceeded";
+        if (wall_ms > 0 && wall > wall_ms) return "time limit exceeded";
+        return nullptr;
+    }
+};
+
+// 一次决策的资源占用
+struct Usage {
+    double wall_ms = 0;
+    double cpu_ms = 0;
+    long peak_rss_kb = 0;
+};
+
+class BotProcess;
+
+// 一次正在进行的决策
+struct Decision {
+    BotProcess* proc = nullptr;  // 为空表示启动失败
+    bool until_eof = false;      // 单次启动模式读到 EOF 为止，长时运行模式读到一行为止
+    bool done = false;           // 发起时已经同步完成 (进程内插件或缓存命中)
+    bool cacheable = false;      // 结果可以写入决策缓存
+    uint64_t cache_key = 0;
+};
+
+class BotProcess {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    std::string buffer;  // 已读入但尚未按行取走的输出
+#ifdef _WIN32
+    HANDLE process = NULL;
+    HANDLE to_child = NULL;
+    HANDLE from_child = NULL;
+#else
+    pid_t pid = -1;
+    int to_child = -1;
+    int from_child = -1;
+#endif
+    Clock::time_point began;  // 本次决策开始的时刻
+    double cpu_base = 0;      // 本次决策开始时进程已用的 CPU 时间 (毫秒)
+    bool exited = false;      // 本次决策中进程已被回收，以下为其最终的资源占用
+    double exit_cpu_ms = 0;
+    long exit_rss_kb = 0;
+
+    // 进程到目前为止的 CPU 时间 (毫秒)，取不到时返回 cpu_base
+    double cpu_now() const {
+#ifdef _WIN32
+        FILETIME created, ended, kernel, user;
+        if (!GetProcessTimes(process, &created, &ended, &kernel, &user)) return cpu_base;
+        return (filetime(kernel) + filetime(user)) / 1e4;
+#else
+        clockid_t clock;
+        timespec ts;
+        if (clock_getcpuclockid(pid, &clock) != 0 || clock_gettime(clock, &ts) != 0) return cpu_base;
+        return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+#endif
+    }
+
+    // 进程到目前为止的峰值内存 (KB)
+    long peak_rss_now() const {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (!K32GetProcessMemoryInfo(process, &pmc, sizeof(pmc))) return 0;
+        return (long)(pmc.PeakWorkingSetSize / 1024);
+#else
+        std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+        for (std::string line; std::getline(status, line);)
+            if (line.compare(0, 6, "VmHWM:") == 0) return std::atol(line.c_str() + 6);
+        return 0;
+#endif
+    }
+
+#ifdef _WIN32
+    static double filetime(const FILETIME& t) { return (double)(((unsigned long long)t.dwHighDateTime << 32) | t.dwLowDateTime); }
+#endif
+
+    // 读取一块数据追加到 buffer: 1 读到数据, 0 进程已关闭输出, -1 暂时没有数据
+    int fill() {
+        char chunk[4096];
+#ifdef _WIN32
+        // 管道里没有数据时 ReadFile 会阻塞，先看一眼
+        DWORD n = 0, avail = 0;
+        if (!PeekNamedPipe(from_child, NULL, 0, NULL, &avail, NULL)) return 0;
+        if (avail == 0) return -1;
+        if (!ReadFile(from_child, chunk, sizeof(chunk), &n, NULL) || n == 0) return 0;
+#else
+        ssize_t n;
+        do n = read(from_child, chunk, sizeof(chunk)); while (n < 0 && errno == EINTR);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return -1;
+        if (n <= 0) return 0;
+#endif
+        buffer.append(chunk, n);
+        return 1;
+    }
+
+    // 等待有输出可读，最多等到 deadline
+    void wait_output(Clock::time_point deadline) {
+        int timeout = -1;
+        if (deadline != Clock::time_point::max()) {
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            timeout = (int)std::max<long long>(left, 0);
+        }
+#ifdef _WIN32
+        // 匿名管道不能等待，每毫秒看一次
+        for (DWORD avail = 0; PeekNamedPipe(from_child, NULL, 0, NULL, &avail, NULL) && avail == 0; timeout--) {
+            if (timeout == 0) return;
+            Sleep(1);
+        }
+#else
+        pollfd pfd = {from_child, POLLIN, 0};
+        poll(&pfd, 1, timeout);
+#endif
+    }
+
+    // 从 buffer 中取出一行 response，跳过空行和长时运行标记
+    bool take_line(std::string& line) {
+        size_t pos;
+        while ((pos = buffer.find('\n')) != std::string::npos) {
+            line = buffer.substr(0, pos);
+            buffer.erase(0, pos + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty() && line != KEEP_RUNNING_MARK) return true;
+        }
+        return false;
+    }
+
+public:
+    BotProcess() = default;
+    BotProcess(const BotProcess&) = delete;
+    BotProcess& operator=(const BotProcess&) = delete;
+    ~BotProcess() { stop(); }
+
+    bool running() const {
+#ifdef _WIN32
+        return process != NULL;
+#else
+        return pid > 0;
+#endif
+    }
+
+    // arg 非空时作为 bot 的唯一命令行参数
+    bool start(const std::string& exe, const char* arg = nullptr) {
+        stop();
+        exited = false;
+        cpu_base = 0;
+#ifdef _WIN32
+        // 串行化创建过程，避免并发启动的子进程继承到彼此的管道句柄
+        static std::mutex spawn_lock;
+        std::lock_guard<std::mutex> guard(spawn_lock);
+        SECURITY_ATTRIBUTES sa = {sizeof(sa), NULL, TRUE};
+        HANDLE in_r, in_w, out_r, out_w;
+        if (!CreatePipe(&out_r, &out_w, &sa, 0)) return false;
+        if (!CreatePipe(&in_r, &in_w, &sa, 0)) {
+            CloseHandle(out_r); CloseHandle(out_w);
+            return false;
+        }
+        SetHandleInformation(out_r, HANDLE_FLAG_INHERIT, 0);
+        SetHandleInformation(in_w, HANDLE_FLAG_INHERIT, 0);
+
+        STARTUPINFOA si = {};
+        si.cb = sizeof(si);
+        si.dwFlags = STARTF_USESTDHANDLES;
+        si.hStdInput = in_r;
+        si.hStdOutput = out_w;
+        si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+        PROCESS_INFORMATION pi = {};
+        std::string cmd = exe;
+        for (char& c : cmd) if (c == '/') c = '\\';
+        if (arg && *arg) {
+            // 按 C 运行库的规则转义参数中的引号
+            cmd += " \"";
+            for (const char* p = arg; *p; p++) {
+                if (*p == '"') cmd += '\\';
+                cmd += *p;
+            }
+            cmd += '"';
+        }
+        BOOL ok = CreateProcessA(NULL, &cmd[0], NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi);
+        CloseHandle(in_r);
+        CloseHandle(out_w);
+        if (!ok) {
+            CloseHandle(in_w); CloseHandle(out_r);
+            return false;
+        }
+        CloseHandle(pi.hThread);
+        process = pi.hProcess;
+        to_child = in_w;
+        from_child = out_r;
+#else
+        int in_pipe[2], out_pipe[2];
+        if (pipe2(in_pipe, O_CLOEXEC) < 0) return false;
+        if (pipe2(out_pipe, O_CLOEXEC) < 0) {
+            close(in_pipe[0]); close(in_pipe[1]);
+            return false;
+        }
+        // dup2 得到的 0/1 不带 O_CLOEXEC，exec 后只有它们留给 bot；
+        // 引擎忽略了 SIGPIPE，bot 里恢复默认处理
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, in_pipe[0], STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+        posix_spawnattr_t attr;
+        posix_spawnattr_init(&attr);
+        sigset_t defaults;
+        sigemptyset(&defaults);
+        sigaddset(&defaults, SIGPIPE);
+        posix_spawnattr_setsigdefault(&attr, &defaults);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+        char* argv[] = {(char*)exe.c_str(), arg && *arg ? (char*)arg : nullptr, nullptr};
+        int error = posix_spawn(&pid, exe.c_str(), &actions, &attr, argv, environ);
+        posix_spawnattr_destroy(&attr);
+        posix_spawn_file_actions_destroy(&actions);
+        close(in_pipe[0]);
+        close(out_pipe[1]);
+        if (error != 0) {
+            pid = -1;
+            close(in_pipe[1]); close(out_pipe[0]);
+            return false;
+        }
+        to_child = in_pipe[1];
+        from_child = out_pipe[0];
+        // 输出端设为非阻塞，便于事件循环复用；阻塞读取时用 poll 等待
+        fcntl(from_child, F_SETFL, fcntl(from_child, F_GETFL) | O_NONBLOCK);
+#endif
+        buffer.clear();
+        return true;
+    }
+
+    // 接管 other 的进程 (例如进程池里预先启动的进程)，other 变为未启动
+    void take(BotProcess& other) {
+        stop();
+        buffer.swap(other.buffer);
+#ifdef _WIN32
+        std::swap(process, other.process);
+#else
+        std::swap(pid, other.pid);
+#endif
+        std::swap(to_child, other.to_child);
+        std::swap(from_child, other.from_child);
+        std::swap(began, other.began);
+        std::swap(cpu_base, other.cpu_base);
+        exited = false;
+    }
+
+    // 写入一行 (自动补换行)
+    bool send_line(std::string_view line) {
+        if (!running()) return false;
+#ifdef _WIN32
+        std::string data(line);
+        data += '\n';
+        size_t done = 0;
+        while (done < data.size()) {
+            DWORD n = 0;
+            if (!WriteFile(to_child, data.data() + done, (DWORD)(data.size() - done), &n, NULL)) return false;
+            done += n;
+        }
+#else
+        // 内容和换行一次写入，不拼接新字符串
+        iovec iov[2] = {{(void*)line.data(), line.size()}, {(void*)"\n", 1}};
+        int first = 0;
+        while (first < 2) {
+            ssize_t n = writev(to_child, iov + first, 2 - first);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            while (first < 2 && (size_t)n >= iov[first].iov_len) n -= iov[first++].iov_len;
+            if (first < 2) {
+                iov[first].iov_base = (char*)iov[first].iov_base + n;
+                iov[first].iov_len -= n;
+            }
+        }
+#endif
+        return true;
+    }
+
+    // 关闭 bot 的 stdin，单次启动的 bot 由此得知输入结束
+    void close_input() {
+#ifdef _WIN32
+        if (to_child) CloseHandle(to_child);
+        to_child = NULL;
+#else
+        if (to_child >= 0) close(to_child);
+        to_child = -1;
+#endif
+    }
+
+#ifndef _WIN32
+    // 输出管道的描述符，供 epoll 等待
+    int out_fd() const { return from_child; }
+#endif
+
+    // 不阻塞地尝试读取下一行 response；返回 true 表示得到结果 (进程退出时结果为已读到的残余内容)
+    bool try_read_line(std::string& line) {
+        while (running()) {
+            if (take_line(line)) return true;
+            int r = fill();
+            if (r < 0) return false;
+            if (r == 0) {
+                line.clear();
+                line.swap(buffer);
+                stop();
+                return true;
+            }
+        }
+        line.clear();
+        return true;
+    }
+
+    // 不阻塞地读取输出，直到进程关闭 stdout 时返回 true 并给出全部输出
+    bool try_read_all(std::string& output) {
+        while (running()) {
+            int r = fill();
+            if (r < 0) return false;
+            if (r == 0) {
+                output.clear();
+                output.swap(buffer);
+                stop();
+                return true;
+            }
+        }
+        output.clear();
+        return true;
+    }
+
+    bool try_read(std::string& output, bool until_eof) {
+        return until_eof ? try_read_all(output) : try_read_line(output);
+    }
+
+    // 阻塞等待本次决策的结果；超出限制时结束进程并返回原因
+    const char* await(std::string& output, bool until_eof, const Limits& limits) {
+        while (!try_read(output, until_eof)) {
+            if (const char* reason = overrun(limits)) {
+                stop();
+                return reason;
+            }
+            wait_output(next_check(limits));
+        }
+        return nullptr;
+    }
+
+    // 开始一次决策，在启动进程或写入请求之前调用
+    void begin_decision() {
+        began = Clock::now();
+        exited = false;
+        cpu_base = 0;
+        if (running()) cpu_base = cpu_now();
+    }
+
+    // 只把墙钟时间改从现在算起，CPU 时间仍从 begin_decision() 算起 (接管提前启动的决策时使用)
+    void restart_clock() { began = Clock::now(); }
+
+    // 本次决策到目前为止的资源占用
+    Usage usage() const {
+        Usage u;
+        u.wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - began).count();
+        if (exited) {
+            u.cpu_ms = exit_cpu_ms - cpu_base;
+            u.peak_rss_kb = exit_rss_kb;
+        }
+        else if (running()) {
+            u.cpu_ms = cpu_now() - cpu_base;
+            u.peak_rss_kb = peak_rss_now();
+        }
+        return u;
+    }
+
+    // 本次决策是否已经超限
+    const char* overrun(const Limits& limits) const {
+        if (limits.wall_ms <= 0 && limits.cpu_ms <= 0) return nullptr;
+        Usage u = usage();
+        return limits.exceeded(u.wall_ms, u.cpu_ms);
+    }
+
+    // 下一次需要检查是否超限的时刻，不限制时为 time_point::max()
+    Clock::time_point next_check(const Limits& limits) const {
+        Clock::time_point next = Clock::time_point::max();
+        if (limits.wall_ms > 0) next = began + std::chrono::milliseconds(limits.wall_ms);
+        if (limits.cpu_ms > 0 && running()) {
+            // 单线程的 bot 用掉的 CPU 时间不会超过墙钟时间，剩余的额度用完之前不必再查
+            double left = limits.cpu_ms - (cpu_now() - cpu_base);
+            auto wait = std::chrono::microseconds((long long)(std::max(left, 0.0) * 1000) + 1000);
+            next = std::min(next, Clock::now() + wait);
+        }
+        return next;
+    }
+
+    void stop() {
+        if (!running()) return;
+        close_input();
+#ifdef _WIN32
+        CloseHandle(from_child);
+        TerminateProcess(process, 0);
+        WaitForSingleObject(process, INFINITE);
+        exit_cpu_ms = cpu_now();
+        exit_rss_kb = peak_rss_now();
+        exited = true;
+        CloseHandle(process);
+        process = from_child = NULL;
+#else
+        close(from_child);
+        kill(pid, SIGKILL);
+        rusage ru;
+        if (wait4(pid, NULL, 0, &ru) == pid) {
+            exit_cpu_ms = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e3 + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e3;
+            exit_rss_kb = ru.ru_maxrss;
+            exited = true;
+        }
+        pid = -1;
+        from_child = -1;
+#endif
+        buffer.clear();
+    }
+};
+
+#endif // BOT_PROCESS_H
@@ -1,9 +1,15 @@
 /**
  * C++ Bridge - 连接到后端服务器
  * 负责启动 C++ 进程并将其输出转发到后端 WebSocket 服务器
+ *
+ * 分片运行 (一场比赛由多个 C++ 进程分担，后端合并成绩):
+ *   node bridge-client.js --shard i/n --seed s   只运行第 i 个分片 (可以在不同机器上，种子必须相同)
+ *   node bridge-client.js --shards n             在本机启动 n 个分片，自动选取共同的种子
+ *
+ * config.yaml 中 uplink: websocket 时引擎自己连接后端，bridge 只负责启动引擎和打印日志
  */
 
-const { spawn } = require('child_process');
+const { spawn, fork } = require('child_process');
 const WebSocket = require('ws');
 const path = require('path');
 const fs = require('fs');
@@ -26,11 +32,25 @@ try {
 }
 
 
-const BACKEND_WS_URL = config.backend_url || DEFAULT_WS_URL;
+// 命令行参数
+const args = {};
+for (let i = 2; i + 1 < process.argv.length; i += 2) {
+  args[process.argv[i].replace(/^--/, '')] = process.argv[i + 1];
+}
+const SHARD = args.shard || null;  // "i/n"
+const SHARD_ID = SHARD ? SHARD.split('/')[0] : null;
+const ENGINE_UPLINK = config.uplink === 'websocket';
+
+let BACKEND_WS_URL = config.backend_url || DEFAULT_WS_URL;
+if (SHARD) {
+  BACKEND_WS_URL += (BACKEND_WS_URL.includes('?') ? '&' : '?') + `worker=${SHARD_ID}`;
+}
 
 let ws = null;
 let reconnectTimer = null;
 let cppProcess = null;
+let pendingMessages = [];  // 连接建立之前要发的消息，连上后按顺序补发
+const shardChildren = [];  // --shards 启动的各分片 bridge
 
 // 连接到后端服务器
 function connectToBackend() {
@@ -47,6 +67,8 @@ function connectToBackend() {
       clearTimeout(reconnectTimer);
       reconnectTimer = null;
     }
+    pendingMessages.forEach(message => ws.send(message));
+    pendingMessages = [];
     
     // 连接成功后启动 C++ 进程
     if (!cppProcess) {
@@ -80,8 +102,12 @@ function connectToBackend() {
 
 // 发送数据到后端
 function sendToBackend(data) {
+  if (ENGINE_UPLINK && !ws) return;  // 引擎自己上报，日志只在本地打印
   if (ws && ws.readyState === WebSocket.OPEN) {
     ws.send(JSON.stringify(data));
+  } else if (ws && ws.readyState === WebSocket.CONNECTING) {
+    // 引擎退回 stdout 时第一条 init 到达时连接还没建立，先存起来
+    pendingMessages.push(JSON.stringify(data));
   } else {
     console.warn('⚠️  后端未连接,数据未发送:', data.type);
   }
@@ -98,13 +124,17 @@ function startCppProcess() {
     return;
   }
 
-  console.log(`🚀 启动 C++ 进程: ${EXE_PATH}`);
-  cppProcess = spawn(EXE_PATH);
+  const cppArgs = [];
+  if (SHARD) cppArgs.push('--shard', SHARD);
+  if (args.seed) cppArgs.push('--seed', args.seed);
+  console.log(`🚀 启动 C++ 进程: ${EXE_PATH} ${cppArgs.join(' ')}`);
+  cppProcess = spawn(EXE_PATH, cppArgs);
 
-  // 处理标准输出
+  // 处理标准输出，一行可能跨多个数据块，最后不完整的一行留到下一块
+  let pending = '';
   cppProcess.stdout.on('data', (data) => {
-    const text = data.toString();
-    const lines = text.split('\n');
+    const lines = (pending + data.toString()).split('\n');
+    pending = lines.pop();
 
     lines.forEach(line => {
       const trimmed = line.trim();
@@ -115,6 +145,8 @@ function startCppProcess() {
         try {
           const jsonStr = trimmed.replace('JSON_DATA:', '');
           const jsonData = JSON.parse(jsonStr);
+          // 引擎没能连上后端时退回 stdout，由 bridge 转发
+          if (ENGINE_UPLINK && !ws) connectToBackend();
           
           // 转发到后端
           sendToBackend(jsonData);
@@ -185,6 +217,7 @@ function scheduleReconnect() {
 // 优雅关闭
 function cleanup() {
   console.log('\n正在清理资源...');
+  shardChildren.forEach(child => child.kill('SIGTERM'));
   
   if (cppProcess) {
     console.log('正在终止 C++ 进程...');
@@ -205,8 +238,18 @@ function cleanup() {
 process.on('SIGINT', cleanup);
 process.on('SIGTERM', cleanup);
 
+// 在本机启动 n 个分片，每个分片是一个独立的 bridge 子进程
+function startShards(count) {
+  const seed = args.seed || String(Date.now());
+  for (let i = 0; i < count; i++) {
+    shardChildren.push(fork(__filename, ['--shard', `${i}/${count}`, '--seed', seed]));
+  }
+}
+
 // 启动
 console.log('═══════════════════════════════════════');
-console.log('🎮 C++ Bridge Client');
+console.log(SHARD ? `🎮 C++ Bridge Client (shard ${SHARD})` : '🎮 C++ Bridge Client');
 console.log('═══════════════════════════════════════');
-connectToBackend();
+if (args.shards && !SHARD) startShards(parseInt(args.shards, 10));
+else if (ENGINE_UPLINK) startCppProcess();
+else connectToBackend();
@@ -0,0 +1,106 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+// 决策缓存：确定性的 bot 对同样的输入总是给出同样的输出，
+// 以 (bot 可执行文件, 完整交互记录) 的 64 位哈希为键保存输出，命中时不再启动 bot。
+// 缓存按键分成 SHARDS 片，每片一把锁、各自按 LRU 淘汰，工作线程之间很少争用同一把锁。
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+// MurmurHash64A，每次处理 8 字节
+inline uint64_t hash_bytes(std::string_view data, uint64_t seed = 0) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    uint64_t h = seed ^ (data.size() * m);
+    const char* p = data.data();
+    const char* end = p + data.size() / 8 * 8;
+    for (; p != end; p += 8) {
+        uint64_t k;
+        memcpy(&k, p, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, p, data.size() & 7);
+    if (data.size() & 7) {
+        h ^= tail;
+        h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+class DecisionCache {
+public:
+    // capacity 为总条目数，0 表示关闭
+    void init(size_t capacity) {
+        shards = std::vector<Shard>(capacity ? SHARDS : 0);
+        for (Shard& shard : shards) shard.capacity = (capacity + SHARDS - 1) / SHARDS;
+    }
+
+    bool enabled() const { return !shards.empty(); }
+
+    bool find(uint64_t key, std::string& value) {
+        Shard& shard = shard_of(key);
+        {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            auto it = shard.index.find(key);
+            if (it != shard.index.end()) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+                value = it->second->second;
+                hit_count++;
+                return true;
+            }
+        }
+        miss_count++;
+        return false;
+    }
+
+    void insert(uint64_t key, std::string_view value) {
+        Shard& shard = shard_of(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return;
+        }
+        if (shard.index.size() >= shard.capacity) {
+            shard.index.erase(shard.lru.back().first);
+            shard.lru.pop_back();
+        }
+        shard.lru.emplace_front(key, std::string(value));
+        shard.index[key] = shard.lru.begin();
+    }
+
+    long long hits() const { return hit_count; }
+    long long misses() const { return miss_count; }
+
+private:
+    static constexpr size_t SHARDS = 64;
+    struct alignas(64) Shard {
+        std::mutex lock;
+        size_t capacity = 0;
+        std::list<std::pair<uint64_t, std::string>> lru;  // 最近使用的在前
+        std::unordered_map<uint64_t, std::list<std::pair<uint64_t, std::string>>::iterator> index;
+    };
+    std::vector<Shard> shards;
+    std::atomic<long long> hit_count{0}, miss_count{0};
+
+    // 高位选片，低位留给片内的哈希表
+    Shard& shard_of(uint64_t key) { return shards[(key >> 58) % SHARDS]; }
+};
+
+#endif // CACHE_H
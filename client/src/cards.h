@@ -0,0 +1,83 @@
+#ifndef CARDS_H
+#define CARDS_H
+
+// 牌的编号: 0..51 每 4 张一个点数 (3 4 5 ... K A 2)，52 小王，53 大王
+// 点数 (level): 0..12 对应 3..2，13 小王，14 大王
+// CardSet 用一个 64 位整数的第 card 位表示是否持有 card 号牌，
+// 插入/删除/子集判断都是 O(1)，张数和每个点数的张数用 popcount 计算。
+
+#include <cstdint>
+#include <array>
+
+constexpr short card2level(short card){return card/4 + card/53;}
+
+constexpr int CARD_COUNT = 54;
+constexpr int LEVEL_COUNT = 15;
+
+// 每个点数对应的牌位
+constexpr std::array<uint64_t, LEVEL_COUNT> make_level_masks() {
+    std::array<uint64_t, LEVEL_COUNT> masks = {};
+    for (int card = 0; card < CARD_COUNT; card++) masks[card2level(card)] |= 1ULL << card;
+    return masks;
+}
+constexpr std::array<uint64_t, LEVEL_COUNT> LEVEL_MASK = make_level_masks();
+
+class CardSet {
+public:
+    constexpr CardSet() = default;
+    constexpr explicit CardSet(uint64_t bits) : bits(bits & ALL) {}
+
+    template <class It>
+    static CardSet of(It first, It last) {
+        CardSet s;
+        for (; first != last; ++first) s.insert(*first);
+        return s;
+    }
+
+    uint64_t mask() const { return bits; }
+    int size() const { return __builtin_popcountll(bits); }
+    bool empty() const { return bits == 0; }
+    void clear() { bits = 0; }
+
+    // 超出 0..53 的编号不是合法的牌，忽略
+    void insert(int card) { if (card >= 0 && card < CARD_COUNT) bits |= 1ULL << card; }
+    void erase(int card) { if (card >= 0 && card < CARD_COUNT) bits &= ~(1ULL << card); }
+    void insert(CardSet other) { bits |= other.bits; }
+    void erase(CardSet other) { bits &= ~other.bits; }
+    bool contains(int card) const { return card >= 0 && card < CARD_COUNT && (bits >> card & 1); }
+    bool includes(CardSet other) const { return (other.bits & ~bits) == 0; }
+
+    // 最小/最大的牌，集合不能为空
+    short first() const { return __builtin_ctzll(bits); }
+    short last() const { return 63 - __builtin_clzll(bits); }
+
+    // 点数为 level 的张数
+    int count(int level) const { return __builtin_popcountll(bits & LEVEL_MASK[level]); }
+    std::array<int, LEVEL_COUNT> level_counts() const {
+        std::array<int, LEVEL_COUNT> counts;
+        for (int level = 0; level < LEVEL_COUNT; level++) counts[level] = count(level);
+        return counts;
+    }
+
+    bool operator==(CardSet other) const { return bits == other.bits; }
+    bool operator!=(CardSet other) const { return bits != other.bits; }
+
+    // 按编号从小到大遍历
+    class iterator {
+    public:
+        explicit iterator(uint64_t rest) : rest(rest) {}
+        short operator*() const { return __builtin_ctzll(rest); }
+        iterator& operator++() { rest &= rest - 1; return *this; }
+        bool operator!=(const iterator& other) const { return rest != other.rest; }
+    private:
+        uint64_t rest;
+    };
+    iterator begin() const { return iterator(bits); }
+    iterator end() const { return iterator(0); }
+
+private:
+    static constexpr uint64_t ALL = (1ULL << CARD_COUNT) - 1;
+    uint64_t bits = 0;
+};
+
+#endif // CARDS_H
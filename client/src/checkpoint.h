@@ -0,0 +1,169 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// 断点续打：定期把比赛进度写成一个小的二进制文件，进程中断后用同样的配置重新运行即从断点继续。
+// 文件 = CheckpointHeader + 比赛参数 (种子、轮数、分片、玩家列表，续打时逐项核对)
+//        + 已打完的轮次集合 + 总成绩 + 评分；数值逐字节按小端序读写，与主机的字节序无关。
+// 只在一轮的成绩合并进总成绩之后写入，文件里的成绩和已打完的轮次总是一致的；
+// 打到一半的轮次不计入，续打时整轮重打 (第 r 轮的牌和座位只由种子和 r 决定，重打的结果相同)。
+// 先写临时文件再改名替换，写到一半中断也不会损坏上一份检查点。
+// Scoreboard / Ratings 等通过 serialize(Archive&) 读写自己的状态，同一个函数用于保存和加载。
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <system_error>
+#include <type_traits>
+
+constexpr uint32_t CHECKPOINT_MAGIC = 0x4B434642;  // "BFCK"
+constexpr uint32_t CHECKPOINT_VERSION = 3;
+
+struct CheckpointHeader {
+    uint32_t magic = CHECKPOINT_MAGIC;
+    uint32_t version = CHECKPOINT_VERSION;
+
+    template <class Archive>
+    void serialize(Archive& ar) {
+        ar.io(magic);
+        ar.io(version);
+    }
+};
+
+// 与 T 同样大小的无符号整数，按它的位模式逐字节读写 (double 也一样)
+template <size_t N> struct CheckpointBits;
+template <> struct CheckpointBits<1> { using type = uint8_t; };
+template <> struct CheckpointBits<2> { using type = uint16_t; };
+template <> struct CheckpointBits<4> { using type = uint32_t; };
+template <> struct CheckpointBits<8> { using type = uint64_t; };
+
+class CheckpointWriter {
+public:
+    static constexpr bool loading = false;
+
+    template <class T>
+    void io(T& value) {
+        static_assert(std::is_arithmetic<T>::value, "checkpoint fields must be numbers");
+        typename CheckpointBits<sizeof(T)>::type bits;
+        memcpy(&bits, &value, sizeof(T));
+        for (size_t i = 0; i < sizeof(T); i++) data += (char)(uint8_t)(bits >> (8 * i));
+    }
+
+    void io(std::string& s) {
+        uint32_t n = s.size();
+        io(n);
+        data.append(s);
+    }
+
+    template <class T>
+    void io(std::vector<T>& v) {
+        uint32_t n = v.size();
+        io(n);
+        for (T& x : v) io(x);
+    }
+
+    // 写入 path.tmp 再改名为 path
+    bool commit(const std::string& path) {
+        std::string tmp = path + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f) return false;
+        bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+        ok = fclose(f) == 0 && ok;
+        std::error_code ec;
+        if (ok) std::filesystem::rename(tmp, path, ec);
+        return ok && !ec;
+    }
+
+private:
+    std::string data;
+};
+
+class CheckpointReader {
+public:
+    static constexpr bool loading = true;
+
+    bool open(const std::string& path) {
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) return false;
+        char buf[1 << 16];
+        for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;) data.append(buf, n);
+        fclose(f);
+        return true;
+    }
+
+    template <class T>
+    void io(T& value) {
+        if (offset + sizeof(T) > data.size()) {
+            broken = true;
+            return;
+        }
+        static_assert(std::is_arithmetic<T>::value, "checkpoint fields must be numbers");
+        typename CheckpointBits<sizeof(T)>::type bits = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            bits |= (typename CheckpointBits<sizeof(T)>::type)(uint8_t)data[offset + i] << (8 * i);
+        memcpy(&value, &bits, sizeof(T));
+        offset += sizeof(T);
+    }
+
+    void io(std::string& s) {
+        uint32_t n = 0;
+        io(n);
+        if (broken || offset + n > data.size()) {
+            broken = true;
+            return;
+        }
+        s.assign(data, offset, n);
+        offset += n;
+    }
+
+    template <class T>
+    void io(std::vector<T>& v) {
+        uint32_t n = 0;
+        io(n);
+        if (broken || n > data.size() - offset) {  // 每个元素至少 1 字节
+            broken = true;
+            return;
+        }
+        v.resize(n);
+        for (T& x : v) io(x);
+    }
+
+    // 读过头或有多余的字节都说明文件不完整或格式不对
+    bool ok() const { return !broken && offset == data.size(); }
+    bool failed() const { return broken; }
+
+private:
+    std::string data;
+    size_t offset = 0;
+    bool broken = false;
+};
+
+// 已打完的轮次 (整场比赛的轮次编号 0..n-1)，按位存储
+class RoundSet {
+public:
+    void init(int rounds) {
+        n = rounds;
+        bits.assign((rounds + 63) / 64, 0);
+    }
+    void insert(int round) { bits[round >> 6] |= 1ULL << (round & 63); }
+    bool contains(int round) const { return bits[round >> 6] >> (round & 63) & 1; }
+    int size() const {
+        int count = 0;
+        for (uint64_t w : bits) count += __builtin_popcountll(w);
+        return count;
+    }
+
+    template <class Archive>
+    void serialize(Archive& ar) {
+        ar.io(n);
+        ar.io(bits);
+    }
+
+private:
+    int n = 0;
+    std::vector<uint64_t> bits;
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,162 @@
+#ifndef DEAL_BANK_H
+#define DEAL_BANK_H
+
+// 牌库：预先生成的一组发牌，第 r 轮用第 r 副，不同实验、不同分片可以打完全相同的牌。
+// 文件 = DealBankHeader + count 条 DealRecord (每条 24 字节: 三家各 17 张的牌掩码，底牌为其余 3 张)。
+// 由 deal_bank 工具离线生成，可以只保留三家手牌强度相近的牌 (见 hand_strength)，减小牌运带来的方差。
+// 引擎把文件只读映射到内存，按下标直接取用；多个引擎进程映射同一个文件时共用页缓存，不复制。
+// 所有整数按小端序存储。
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "cards.h"
+
+constexpr uint32_t DEAL_BANK_MAGIC = 0x42444642;  // "BFDB"
+constexpr uint32_t DEAL_BANK_VERSION = 1;
+
+struct DealBankHeader {
+    uint32_t magic = DEAL_BANK_MAGIC;
+    uint32_t version = DEAL_BANK_VERSION;
+    uint32_t record_size = 0;  // sizeof(DealRecord)，读取时用来检查格式
+    int32_t max_spread = -1;   // 生成时允许的三家强度之差的上限，-1 表示没有筛选
+    uint64_t count = 0;        // 记录数
+    uint64_t seed = 0;         // 生成时的种子
+};
+static_assert(sizeof(DealBankHeader) == 32, "DealBankHeader layout changed");
+
+struct DealRecord {
+    uint64_t hands[3];
+
+    CardSet hand(int seat) const { return CardSet(hands[seat]); }
+    CardSet publics() const { return CardSet(~(hands[0] | hands[1] | hands[2])); }
+};
+static_assert(sizeof(DealRecord) == 24, "DealRecord layout changed");
+
+// 粗略的手牌强度 (17 张，不含底牌)，只用于筛选牌局，越大越好：
+// 大牌按张计分 (A 1、2 2、小王 3、大王 4)，炸弹和王炸各加 4；
+// 3..10 中既不成对、也不在 5 张以上顺子里的单张各减 1
+inline int hand_strength(CardSet hand) {
+    static constexpr int HIGH[LEVEL_COUNT] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4};
+    int strength = 0;
+    unsigned present = 0;  // 有牌的点数
+    for (int level = 0; level < LEVEL_COUNT; level++) {
+        int n = hand.count(level);
+        strength += HIGH[level] * n;
+        if (n == 4) strength += 4;
+        if (n) present |= 1u << level;
+    }
+    if (hand.count(13) && hand.count(14)) strength += 4;
+    // 顺子只能用 3..A (点数 0..11)
+    unsigned chained = 0;
+    for (int level = 0; level < 12;) {
+        int end = level;
+        while (end < 12 && present >> end & 1) end++;
+        if (end - level >= 5) chained |= ((1u << (end - level)) - 1) << level;
+        level = std::max(end, level + 1);
+    }
+    for (int level = 0; level < 8; level++)
+        if (hand.count(level) == 1 && !(chained >> level & 1)) strength--;
+    return strength;
+}
+
+// 一副牌三家强度的最大差
+inline int deal_spread(const DealRecord& deal) {
+    int s[3];
+    for (int i = 0; i < 3; i++) s[i] = hand_strength(deal.hand(i));
+    return std::max({s[0], s[1], s[2]}) - std::min({s[0], s[1], s[2]});
+}
+
+class DealBank {
+public:
+    DealBank() = default;
+    DealBank(const DealBank&) = delete;
+    DealBank& operator=(const DealBank&) = delete;
+    ~DealBank() { close(); }
+
+    // 映射文件并检查文件头，失败时 error() 给出原因
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+        if (file == INVALID_HANDLE_VALUE) return fail("cannot open file");
+        LARGE_INTEGER n;
+        GetFileSizeEx(file, &n);
+        size = (size_t)n.QuadPart;
+        if (size > 0) {
+            mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (!mapping) return fail("cannot map file");
+            data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return fail("cannot open file");
+        struct stat st;
+        fstat(fd, &st);
+        size = st.st_size;
+        if (size > 0) {
+            void* p = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) data = (const char*)p;
+        }
+        ::close(fd);
+#endif
+        if (size > 0 && !data) return fail("cannot map file");
+        if (size < sizeof(header)) return fail("file too short");
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != DEAL_BANK_MAGIC) return fail("not a deal bank");
+        if (header.version != DEAL_BANK_VERSION || header.record_size != sizeof(DealRecord)) return fail("unsupported deal bank version");
+        if ((size - sizeof(header)) / sizeof(DealRecord) < header.count) return fail("file truncated");
+        return true;
+    }
+
+    bool is_open() const { return data != nullptr; }
+    uint64_t size_in_deals() const { return header.count; }
+    const DealBankHeader& info() const { return header; }
+    const DealRecord& operator[](uint64_t i) const {
+        return reinterpret_cast<const DealRecord*>(data + sizeof(DealBankHeader))[i];
+    }
+
+    const std::string& error() const { return message; }
+
+    void close() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap((void*)data, size);
+#endif
+        data = nullptr;
+        size = 0;
+        header = DealBankHeader();
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+    const char* data = nullptr;
+    size_t size = 0;
+    DealBankHeader header;
+    std::string message;
+
+    bool fail(const char* reason) {
+        close();
+        message = reason;
+        return false;
+    }
+};
+
+#endif // DEAL_BANK_H
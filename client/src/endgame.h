@@ -0,0 +1,281 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+// 明牌残局求解：三家手牌都已知时，从某个局面起双方都走最优，地主一方能否必胜。
+// 打完的一局按出牌记录重放，进入残局 (每家不超过 max_cards 张) 之后逐个局面求解，
+// 一次出牌前本方必胜、出牌后变成必败，即为一次 "失误"；按座位统计面对必胜局面的决策数和失误数。
+//   手牌: 花色不影响出牌，按点数计数，每个点数 4 位，15 个点数装进一个 64 位整数，出牌就是减法
+//   搜索: 胜负只有两种结果，轮到的一方找到一手必胜即剪枝 (两个农民是同一方)
+//   置换表: 按 (三家手牌、轮到的座位、要压的牌及其出牌人) 的哈希保存结果，同一局的相邻局面大量重复
+//   走法顺序: 一手出完 > 出完剩下的点数少、张数多的 > 炸弹、火箭；队友的牌先试不压，对手的牌最后才过
+// 每个局面有节点数上限，超出时放弃这个局面 (不计入统计)。求解器不是线程安全的，每个线程一个。
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "cards.h"
+#include "moves.h"
+
+namespace endgame {
+
+// 按点数计数的手牌，第 level 个 4 位为该点数的张数
+using Counts = uint64_t;
+
+inline int count_at(Counts hand, int level) { return hand >> (4 * level) & 15; }
+inline Counts unit(int level, int n) { return (Counts)n << (4 * level); }
+
+inline Counts counts_of(CardSet cards) {
+    Counts hand = 0;
+    for (int level = 0; level < LEVEL_COUNT; level++) hand += unit(level, cards.count(level));
+    return hand;
+}
+
+// 每个点数取编号最小的几张，得到一组具体的牌
+inline CardSet cards_of(Counts hand) {
+    CardSet cards;
+    for (int level = 0; level < LEVEL_COUNT; level++) {
+        uint64_t bits = LEVEL_MASK[level];
+        for (int n = count_at(hand, level); n > 0; n--, bits &= bits - 1) cards.insert(__builtin_ctzll(bits));
+    }
+    return cards;
+}
+
+struct Move {
+    Counts cards = 0;
+    Combo combo{PASS, 0, 0, 0};  // 默认为过牌
+};
+
+// 主体每个点数 main 张、带牌方式为 kick、主体最小点数 from 起、点数个数在 [min_length, max_length] 内的全部出法
+template <class Emit>
+void for_each_shape(const int* c, int main, int kick, int from, int min_length, int max_length, Emit& emit) {
+    int picked[8];
+    for (int level = from; level < LEVEL_COUNT; level++) {
+        Counts body = 0;
+        for (int length = 1; length <= max_length && level + length <= LEVEL_COUNT; length++) {
+            int last = level + length - 1;
+            if (c[last] < main || (length > 1 && last >= 12)) break;
+            body += unit(last, main);
+            bool chain = length > 1;
+            if (length < min_length || (chain && length < MIN_CHAIN[main])) continue;
+            ComboType type = chain ? CHAIN_TYPE[main][kick] : SOLO_TYPE[main][kick];
+            if (type == INVALID) continue;
+            int need = kick ? length * KICKS_PER_MAIN[main] : 0;
+            Combo combo{type, level, length, main * length + need * kick};
+            if (!need) {
+                emit(body, combo);
+                continue;
+            }
+            // 带牌取主体以外互不相同的 need 个点数，每个 kick 张
+            int candidates[LEVEL_COUNT], n = 0;
+            for (int l = 0; l < LEVEL_COUNT; l++)
+                if ((l < level || l > last) && c[l] >= kick) candidates[n++] = l;
+            if (n < need || need > 8) continue;
+            for (int i = 0; i < need; i++) picked[i] = i;
+            for (;;) {
+                Counts cards = body;
+                for (int i = 0; i < need; i++) cards += unit(candidates[picked[i]], kick);
+                emit(cards, combo);
+                int i = need - 1;
+                while (i >= 0 && picked[i] == n - need + i) i--;
+                if (i < 0) break;
+                picked[i]++;
+                for (int j = i + 1; j < need; j++) picked[j] = picked[j - 1] + 1;
+            }
+        }
+    }
+}
+
+// hand 能出的全部牌型 (不含过牌)，target 不为空时只生成压得过 target 的；结果与 classify、beats 一致
+template <class Emit>
+void for_each_move(Counts hand, Emit&& emit, const Combo* target = nullptr) {
+    int c[LEVEL_COUNT];
+    for (int level = 0; level < LEVEL_COUNT; level++) c[level] = count_at(hand, level);
+    if (target && target->type == ROCKET) return;
+    if (c[13] && c[14]) emit(unit(13, 1) | unit(14, 1), Combo{ROCKET, 13, 1, 2});
+    if (!target) {
+        for (int main = 1; main <= 4; main++)
+            for (int kick = 0; kick <= 2; kick++) for_each_shape(c, main, kick, 0, 1, LEVEL_COUNT, emit);
+        return;
+    }
+    // 同牌型同长度的更大的一手，再加上炸弹
+    if (target->type != BOMB)
+        for (int main = 1; main <= 4; main++)
+            for (int kick = 0; kick <= 2; kick++)
+                if (SOLO_TYPE[main][kick] == target->type || CHAIN_TYPE[main][kick] == target->type)
+                    for_each_shape(c, main, kick, target->level + 1, target->length, target->length, emit);
+    for_each_shape(c, 4, 0, target->type == BOMB ? target->level + 1 : 0, 1, 1, emit);
+}
+
+// 局面：轮到 turn，要压 target (由 leader 出)；target 为过牌表示 turn 自由出牌
+struct Position {
+    Counts hand[3] = {};
+    int size[3] = {};
+    int turn = 0;
+    int landlord = 0;
+    Move target;
+    int leader = 0;
+
+    bool teammates(int a, int b) const { return a == b || (a != landlord && b != landlord); }
+
+    // turn 出 move (或过牌) 之后的局面
+    Position after(const Move& move) const {
+        Position next = *this;
+        next.turn = (turn + 1) % 3;
+        if (move.combo.type != PASS) {
+            next.hand[turn] -= move.cards;
+            next.size[turn] -= move.combo.size;
+            next.target = move;
+            next.leader = turn;
+        }
+        // 其余两家都过牌，出牌人重新自由出牌
+        if (next.turn == next.leader) next.target = Move();
+        return next;
+    }
+};
+
+enum Value { LANDLORD_LOSES = 0, LANDLORD_WINS = 1, UNKNOWN = 2 };
+
+class Solver {
+public:
+    explicit Solver(int table_bits = 18) : table(size_t(1) << table_bits), mask((size_t(1) << table_bits) - 1) {}
+
+    // 双方都走最优时地主一方是否必胜；搜索超过 node_limit 个节点返回 UNKNOWN
+    Value solve(const Position& p, long long node_limit) {
+        nodes = 0;
+        limit = node_limit;
+        aborted = false;
+        bool wins = search(p, 0);
+        return aborted ? UNKNOWN : wins ? LANDLORD_WINS : LANDLORD_LOSES;
+    }
+
+    long long last_nodes() const { return nodes; }
+
+private:
+    struct Entry {
+        uint64_t key = 0;  // 哈希，最低位存结果
+    };
+    std::vector<Entry> table;
+    size_t mask;
+    struct Candidate {
+        Move move;
+        int key;  // 排序键
+    };
+    std::vector<std::vector<Candidate>> moves;  // 按搜索深度复用
+    long long nodes = 0, limit = 0;
+    bool aborted = false;
+
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    static uint64_t hash(const Position& p) {
+        uint64_t h = mix(p.hand[0] + 0x9e3779b97f4a7c15ULL);
+        h = mix(h ^ p.hand[1]);
+        h = mix(h ^ p.hand[2] ^ ((uint64_t)p.turn << 60) ^ ((uint64_t)p.landlord << 62));
+        if (p.target.combo.type != PASS) h = mix(h ^ p.target.cards ^ ((uint64_t)p.leader << 61));
+        return h & ~1ULL;
+    }
+
+    // 有牌的点数个数，即至少还要出几手 (不计顺子和带牌) 的粗略估计
+    static int levels(Counts hand) {
+        Counts any = (hand | hand >> 1 | hand >> 2 | hand >> 3) & 0x1111111111111111ULL;
+        return __builtin_popcountll(any);
+    }
+
+    // 走法的排序键，越小越先试：出完之后剩下的点数越少越好，其次张数越多越好；炸弹、火箭留到后面；
+    // 队友出的牌先试过牌，对手出的牌最后才过
+    static int order(const Position& p, const Move& m) {
+        if (m.combo.type == PASS) return p.teammates(p.turn, p.leader) ? -1 : 1 << 20;
+        int rest = levels(p.hand[p.turn] - m.cards) * 32 + (31 - m.combo.size);
+        return m.combo.type == BOMB || m.combo.type == ROCKET ? rest + 1024 : rest;
+    }
+
+    bool search(const Position& p, int depth) {
+        bool landlord_moves = p.turn == p.landlord;
+        if (++nodes > limit) {
+            aborted = true;
+            return false;
+        }
+        uint64_t key = hash(p);
+        Entry& e = table[(key >> 1) & mask];
+        if ((e.key & ~1ULL) == key && e.key) return e.key & 1;
+
+        if ((int)moves.size() <= depth) moves.resize(depth + 1);
+        std::vector<Candidate>& list = moves[depth];
+        list.clear();
+        bool free_lead = p.target.combo.type == PASS;
+        int own = p.size[p.turn];
+        bool finishes = false;
+        for_each_move(p.hand[p.turn], [&](Counts cards, const Combo& combo) {
+            if (finishes) return;
+            if (combo.size == own) finishes = true;  // 一手出完，不必再看别的走法
+            Move m{cards, combo};
+            list.push_back(Candidate{m, order(p, m)});
+        }, free_lead ? nullptr : &p.target.combo);
+        if (finishes) return store(e, key, landlord_moves);
+        if (!free_lead) list.push_back(Candidate{Move(), order(p, Move())});
+        std::sort(list.begin(), list.end(), [](const Candidate& a, const Candidate& b) { return a.key < b.key; });
+
+        // 列表在递归中可能因为扩容而移动，按下标访问
+        for (size_t i = 0; i < moves[depth].size(); i++) {
+            Move m = moves[depth][i].move;
+            bool landlord_wins = search(p.after(m), depth + 1);
+            if (aborted) return false;
+            if (landlord_wins == landlord_moves) return store(e, key, landlord_wins);
+        }
+        return store(e, key, !landlord_moves);
+    }
+
+    static bool store(Entry& e, uint64_t key, bool landlord_wins) {
+        e.key = key | (landlord_wins ? 1 : 0);
+        return landlord_wins;
+    }
+};
+
+// 各座位在残局中面对必胜局面的决策数和其中走成必败的次数
+struct Regret {
+    int decisions[3] = {};
+    int blunders[3] = {};
+};
+
+// 按出牌记录 (从地主起按座位轮流，过牌为 0) 重放一局并统计失误；判负结束的局只分析判负之前的出牌
+inline Regret analyze(const CardSet initial[3], CardSet publics, int landlord, const std::vector<uint64_t>& plays,
+                      int max_cards, long long node_limit, Solver& solver) {
+    Regret regret;
+    Position p;
+    for (int i = 0; i < 3; i++) {
+        CardSet hand = initial[i];
+        if (i == landlord) hand.insert(publics);
+        p.hand[i] = counts_of(hand);
+        p.size[i] = hand.size();
+    }
+    p.turn = p.leader = p.landlord = landlord;
+
+    Value before = UNKNOWN;  // 当前局面的值，还没进入残局时为 UNKNOWN
+    for (uint64_t bits : plays) {
+        int mover = p.turn;
+        bool endgame = std::max({p.size[0], p.size[1], p.size[2]}) <= max_cards;
+        if (endgame && before == UNKNOWN) before = solver.solve(p, node_limit);
+        CardSet cards(bits);
+        Move move{counts_of(cards), classify(cards)};
+        Position next = p.after(move);
+        Value after = UNKNOWN;
+        if (next.size[mover] == 0) after = mover == landlord ? LANDLORD_WINS : LANDLORD_LOSES;
+        else if (endgame) after = solver.solve(next, node_limit);
+        Value win = mover == landlord ? LANDLORD_WINS : LANDLORD_LOSES;
+        if (before == win && after != UNKNOWN) {
+            regret.decisions[mover]++;
+            if (after != win) regret.blunders[mover]++;
+        }
+        before = after;
+        p = next;
+        if (p.size[mover] == 0) break;
+    }
+    return regret;
+}
+
+} // namespace endgame
+
+#endif // ENDGAME_H
@@ -0,0 +1,129 @@
+#ifndef MOVES_H
+#define MOVES_H
+
+// 出牌牌型判断与合法性检查 (规则同 Botzone 斗地主)
+// 先按点数统计张数，得到 "张数为 k 的点数集合" (15 位掩码)，
+// 再由主体 (张数最多的部分) 是否连续、带牌的张数和个数决定牌型，全程只有位运算。
+
+#include <array>
+#include "cards.h"
+
+enum ComboType {
+    PASS,        // 过
+    SINGLE,      // 单张
+    PAIR,        // 对子
+    STRAIGHT,    // 顺子 (5 张及以上)
+    STRAIGHT2,   // 连对 (3 对及以上)
+    TRIPLET,     // 三条
+    TRIPLET1,    // 三带一
+    TRIPLET2,    // 三带一对
+    BOMB,        // 炸弹
+    QUADRUPLE2,  // 四带二 (两张单牌)
+    QUADRUPLE4,  // 四带二 (两对)
+    PLANE,       // 飞机
+    PLANE1,      // 飞机带小翼
+    PLANE2,      // 飞机带大翼
+    SSHUTTLE,    // 航天飞机
+    SSHUTTLE2,   // 航天飞机带小翼
+    SSHUTTLE4,   // 航天飞机带大翼
+    ROCKET,      // 火箭
+    INVALID      // 非法牌型
+};
+
+constexpr std::array<const char*, INVALID + 1> COMBO_NAME = {
+    "pass", "single", "pair", "straight", "straight2", "triplet", "triplet1", "triplet2", "bomb",
+    "quadruple2", "quadruple4", "plane", "plane1", "plane2", "sshuttle", "sshuttle2", "sshuttle4",
+    "rocket", "invalid"
+};
+
+// 主体张数 x 带牌方式 (0 不带 / 1 带单张 / 2 带对子) 对应的单个主体牌型和连续主体牌型
+// 主体为三张时每组带 1 份，主体为四张时每组带 2 份
+constexpr ComboType SOLO_TYPE[5][3] = {
+    {INVALID, INVALID, INVALID},
+    {SINGLE, INVALID, INVALID},
+    {PAIR, INVALID, INVALID},
+    {TRIPLET, TRIPLET1, TRIPLET2},
+    {BOMB, QUADRUPLE2, QUADRUPLE4},
+};
+constexpr ComboType CHAIN_TYPE[5][3] = {
+    {INVALID, INVALID, INVALID},
+    {STRAIGHT, INVALID, INVALID},
+    {STRAIGHT2, INVALID, INVALID},
+    {PLANE, PLANE1, PLANE2},
+    {SSHUTTLE, SSHUTTLE2, SSHUTTLE4},
+};
+constexpr int MIN_CHAIN[5] = {0, 5, 3, 2, 2};  // 组成连续主体至少需要的点数个数
+constexpr int KICKS_PER_MAIN[5] = {0, 0, 0, 1, 2};
+constexpr unsigned CHAIN_LEVELS = (1u << 12) - 1;  // 连续主体只能由 3..A 组成
+
+struct Combo {
+    ComboType type = INVALID;
+    int level = 0;   // 主体的最小点数
+    int length = 0;  // 主体的点数个数
+    int size = 0;    // 总张数
+};
+
+inline Combo classify(CardSet cards) {
+    Combo combo;
+    combo.size = cards.size();
+    if (combo.size == 0) {
+        combo.type = PASS;
+        return combo;
+    }
+    if (combo.size == 2 && cards.contains(52) && cards.contains(53)) {
+        combo.type = ROCKET;
+        combo.level = 13;
+        combo.length = 1;
+        return combo;
+    }
+    unsigned with_count[5] = {};  // with_count[k]: 张数为 k 的点数集合
+    for (int level = 0; level < LEVEL_COUNT; level++) with_count[cards.count(level)] |= 1u << level;
+    int main = 4;
+    while (!with_count[main]) main--;
+    unsigned mains = with_count[main];
+    combo.level = __builtin_ctz(mains);
+    combo.length = __builtin_popcount(mains);
+
+    // 带牌: 主体以外的点数必须全是单张或全是对子，份数等于主体组数 x KICKS_PER_MAIN
+    int kick = 0;
+    int kick_count = 0;
+    for (int k = 1; k < main; k++) {
+        if (!with_count[k]) continue;
+        if (kick) return combo;
+        kick = k;
+        kick_count = __builtin_popcount(with_count[k]);
+    }
+    if (kick && (kick > 2 || kick_count != combo.length * KICKS_PER_MAIN[main])) return combo;
+
+    if (combo.length == 1) {
+        combo.type = SOLO_TYPE[main][kick];
+        return combo;
+    }
+    bool consecutive = ((mains >> combo.level) & ((mains >> combo.level) + 1)) == 0;
+    if (consecutive && (mains & ~CHAIN_LEVELS) == 0 && combo.length >= MIN_CHAIN[main])
+        combo.type = CHAIN_TYPE[main][kick];
+    return combo;
+}
+
+// a 能否压过 b (b 不是 PASS)
+inline bool beats(const Combo& a, const Combo& b) {
+    if (a.type == ROCKET) return true;
+    if (b.type == ROCKET) return false;
+    if (a.type == BOMB && b.type != BOMB) return true;
+    return a.type == b.type && a.size == b.size && a.level > b.level;
+}
+
+// 检查一手出牌，合法时返回 nullptr，否则返回原因
+// hand 为出牌前的手牌，history 同 Table::history
+inline const char* check_play(CardSet hand, const CardSet history[2], CardSet play, Combo& combo) {
+    combo = classify(play);
+    if (!hand.includes(play)) return "plays cards not in hand";
+    if (combo.type == INVALID) return "invalid combination";
+    const CardSet& target = history[1].empty() ? history[0] : history[1];
+    if (target.empty()) return combo.type == PASS ? "passes on a free lead" : nullptr;
+    if (combo.type == PASS) return nullptr;
+    if (!beats(combo, classify(target))) return "does not beat the previous play";
+    return nullptr;
+}
+
+#endif // MOVES_H
@@ -0,0 +1,106 @@
+#ifndef PLUGIN_H
+#define PLUGIN_H
+
+// 加载进程内 bot 插件 (ABI 见 bot_plugin.h)
+// 插件在整个比赛期间保持加载，不卸载。
+
+#include <string>
+#include "bot_plugin.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <time.h>
+#endif
+
+inline bool is_plugin_file(const std::string& extension) {
+#ifdef _WIN32
+    return extension == ".dll";
+#else
+    return extension == ".so";
+#endif
+}
+
+// 加载插件，失败时返回 nullptr 并给出原因
+inline const bf_plugin* load_plugin(const std::string& path, std::string& error) {
+#ifdef _WIN32
+    HMODULE lib = LoadLibraryA(path.c_str());
+    if (!lib) {
+        error = "cannot load library";
+        return nullptr;
+    }
+    auto entry = (bf_plugin_entry)(void*)GetProcAddress(lib, BOTFIELD_PLUGIN_ENTRY);
+#else
+    // RTLD_LOCAL: 不同插件中的同名符号互不影响
+    void* lib = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!lib) {
+        error = dlerror();
+        return nullptr;
+    }
+    auto entry = (bf_plugin_entry)dlsym(lib, BOTFIELD_PLUGIN_ENTRY);
+#endif
+    if (!entry) {
+        error = std::string("missing ") + BOTFIELD_PLUGIN_ENTRY;
+        return nullptr;
+    }
+    const bf_plugin* plugin = entry();
+    if (!plugin || plugin->abi_version != BOTFIELD_ABI_VERSION) {
+        error = "unsupported ABI version";
+        return nullptr;
+    }
+    if (!plugin->init || !plugin->reset || !plugin->bid || !plugin->play || !plugin->destroy) {
+        error = "incomplete plugin table";
+        return nullptr;
+    }
+    return plugin;
+}
+
+// 当前线程的 CPU 时间 (毫秒)，插件的决策在调用它的线程上执行
+inline double thread_cpu_ms() {
+#ifdef _WIN32
+    FILETIME created, ended, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &created, &ended, &kernel, &user)) return 0;
+    auto ticks = [](const FILETIME& t) { return ((unsigned long long)t.dwHighDateTime << 32) | t.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) / 1e4;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+#endif
+}
+
+// 一个座位上的插件 bot 实例，换了插件时重新创建
+class NativeBot {
+public:
+    NativeBot() = default;
+    NativeBot(const NativeBot&) = delete;
+    NativeBot& operator=(const NativeBot&) = delete;
+    ~NativeBot() { release(); }
+
+    // 为新的一局准备 plugin 的实例；plugin 为空表示这个座位不是插件
+    void bind(const bf_plugin* next) {
+        if (next != plugin) {
+            release();
+            plugin = next;
+            if (plugin) bot = plugin->init();
+        }
+        if (plugin) plugin->reset(bot);
+    }
+
+    const bf_plugin* get() const { return plugin; }
+
+    int bid(const bf_bid_request& req) { return plugin->bid(bot, &req); }
+    uint64_t play(const bf_play_request& req) { return plugin->play(bot, &req); }
+
+private:
+    const bf_plugin* plugin = nullptr;
+    void* bot = nullptr;
+
+    void release() {
+        if (plugin) plugin->destroy(bot);
+        plugin = nullptr;
+        bot = nullptr;
+    }
+};
+
+#endif // PLUGIN_H
@@ -0,0 +1,86 @@
+#ifndef POOL_H
+#define POOL_H
+
+// 工作窃取任务池：每个工作线程一个双端队列，
+// 自己的任务从队尾取 (刚放进去的任务最先执行)，自己的队列空了就从别的线程的队头偷，
+// 都没有任务时在条件变量上睡眠；close() 之后任务取完即返回 nullptr。
+// 任务是整桌比赛，单次耗时在毫秒以上，每个队列用一把锁即可。
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <condition_variable>
+
+template <class Task>
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int workers) : queues(workers) {}
+
+    int workers() const { return (int)queues.size(); }
+
+    // 把任务放进 worker 的队列
+    void push(int worker, Task* task) {
+        Queue& q = queues[worker % queues.size()];
+        {
+            // 在队列锁内计数，取走任务的线程 (同样持有这把锁) 减计数时一定已经加过
+            std::lock_guard<std::mutex> guard(q.lock);
+            q.tasks.push_back(task);
+            queued++;
+        }
+        // 先计数再通知，睡眠的线程在 idle_lock 下检查计数，不会错过唤醒
+        std::lock_guard<std::mutex> guard(idle_lock);
+        wake.notify_one();
+    }
+
+    // 取一个任务，没有时等待；池已关闭且没有任务时返回 nullptr
+    Task* pop(int worker) {
+        for (;;) {
+            if (Task* task = take(worker)) return task;
+            std::unique_lock<std::mutex> guard(idle_lock);
+            wake.wait(guard, [this] { return queued > 0 || closed; });
+            if (queued == 0 && closed) return nullptr;
+        }
+    }
+
+    // 不再有新任务
+    void close() {
+        std::lock_guard<std::mutex> guard(idle_lock);
+        closed = true;
+        wake.notify_all();
+    }
+
+private:
+    struct alignas(64) Queue {
+        std::mutex lock;
+        std::deque<Task*> tasks;
+    };
+    std::vector<Queue> queues;
+    std::atomic<size_t> queued{0};  // 所有队列中的任务数
+    std::mutex idle_lock;
+    std::condition_variable wake;
+    bool closed = false;
+
+    Task* take(int worker) {
+        size_t n = queues.size();
+        for (size_t i = 0; i < n; i++) {
+            Queue& q = queues[(worker + i) % n];
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (q.tasks.empty()) continue;
+            Task* task;
+            if (i == 0) {
+                task = q.tasks.back();
+                q.tasks.pop_back();
+            }
+            else {
+                task = q.tasks.front();
+                q.tasks.pop_front();
+            }
+            queued--;
+            return task;
+        }
+        return nullptr;
+    }
+};
+
+#endif // POOL_H
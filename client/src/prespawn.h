@@ -0,0 +1,132 @@
+#ifndef PRESPAWN_H
+#define PRESPAWN_H
+
+// 预先启动的 bot 进程池：单次启动且输入写入 stdin 时，进程不必等到要做决策才启动。
+// 后台线程为每个可执行文件维持 per_exe 个已经启动、停在读 stdin 上的空闲进程，
+// 决策时取走一个写入输入即可，启动进程 (exec、动态链接、bot 自身的初始化) 不在关键路径上；
+// 取走之后后台线程立即补上。每个进程仍然只做一次决策，bot 看到的协议不变。
+// 输入作为命令行参数传入 (bot_input: argv) 时，进程要拿到输入才能启动，不能预先启动。
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "bot_process.h"
+
+class PrespawnPool {
+public:
+    PrespawnPool() = default;
+    PrespawnPool(const PrespawnPool&) = delete;
+    PrespawnPool& operator=(const PrespawnPool&) = delete;
+    ~PrespawnPool() { close(); }
+
+    // exes 按玩家 id 给出可执行文件，空串表示该玩家不使用进程池；同一个文件的玩家共用空闲进程
+    void start(const std::vector<std::string>& exes, int per_exe) {
+        close();
+        target = per_exe;
+        entry_of.assign(exes.size(), -1);
+        for (size_t i = 0; i < exes.size(); i++) {
+            if (exes[i].empty()) continue;
+            for (size_t e = 0; e < entries.size() && entry_of[i] < 0; e++)
+                if (entries[e].exe == exes[i]) entry_of[i] = e;
+            if (entry_of[i] >= 0) continue;
+            entry_of[i] = entries.size();
+            entries.emplace_back();
+            entries.back().exe = exes[i];
+            entries.back().idle.reserve(per_exe);
+        }
+        if (entries.empty() || per_exe <= 0) return;
+        closing = false;
+        worker = std::thread([this] { run(); });
+    }
+
+    // 取出玩家 player 的一个空闲进程交给 proc；没有空闲进程时返回 false，由调用方自己启动
+    bool acquire(int player, BotProcess& proc) {
+        if (!worker.joinable() || entry_of[player] < 0) return false;
+        std::lock_guard<std::mutex> guard(lock);
+        Entry& e = entries[entry_of[player]];
+        if (e.idle.empty()) {
+            e.misses++;
+            return false;
+        }
+        std::unique_ptr<BotProcess> p = std::move(e.idle.back());
+        e.idle.pop_back();
+        proc.take(*p);
+        spare.push_back(std::move(p));
+        e.hits++;
+        refill.notify_one();
+        return proc.running();
+    }
+
+    // 取用时已有空闲进程的次数和需要现场启动的次数
+    long long hits() const { return sum(&Entry::hits); }
+    long long misses() const { return sum(&Entry::misses); }
+
+    // 停止后台线程并结束全部空闲进程
+    void close() {
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                closing = true;
+            }
+            refill.notify_one();
+            worker.join();
+        }
+        entries.clear();
+        spare.clear();
+    }
+
+private:
+    struct Entry {
+        std::string exe;
+        std::vector<std::unique_ptr<BotProcess>> idle;
+        bool broken = false;  // 启动失败过，不再预先启动
+        long long hits = 0, misses = 0;
+    };
+    std::vector<Entry> entries;
+    std::vector<int> entry_of;  // 按玩家 id
+    std::vector<std::unique_ptr<BotProcess>> spare;  // 进程被取走后留下的空对象，循环使用
+    int target = 0;
+    std::mutex lock;
+    std::condition_variable refill;
+    std::thread worker;
+    bool closing = false;
+
+    long long sum(long long Entry::*field) const {
+        long long total = 0;
+        for (const Entry& e : entries) total += e.*field;
+        return total;
+    }
+
+    // 每次补空闲进程最少的那个文件，启动进程时不持有锁
+    void run() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (!closing) {
+            Entry* next = nullptr;
+            for (Entry& e : entries)
+                if (!e.broken && (int)e.idle.size() < target && (!next || e.idle.size() < next->idle.size())) next = &e;
+            if (!next) {
+                refill.wait(guard);
+                continue;
+            }
+            std::unique_ptr<BotProcess> p;
+            if (!spare.empty()) {
+                p = std::move(spare.back());
+                spare.pop_back();
+            }
+            else p = std::make_unique<BotProcess>();
+            guard.unlock();
+            bool ok = p->start(next->exe);
+            guard.lock();
+            if (ok) next->idle.push_back(std::move(p));
+            else {
+                next->broken = true;
+                spare.push_back(std::move(p));
+            }
+        }
+    }
+};
+
+#endif // PRESPAWN_H
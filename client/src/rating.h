@@ -0,0 +1,157 @@
+#ifndef RATING_H
+#define RATING_H
+
+// 在线评分 (Glicko)：每个玩家一个评分 r 和评分偏差 RD，每桌打完更新一次。
+// 一桌的三人两两比较本桌得分之和 (duplicate 模式下为 6 种座位排列之和)，高者记胜、相同记平，
+// 三组比较作为同一个评分周期，用更新前的评分一起计算。实力不随时间变化，RD 只减不增。
+// 评分用来排名、安排下一轮的座位，以及判断前 k 名的顺序是否已经确定 (可以提前结束比赛)。
+
+#include <cmath>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+class Ratings {
+public:
+    static constexpr double INITIAL_RATING = 1500;
+    static constexpr double INITIAL_DEVIATION = 350;
+
+    void init(int player_count) {
+        r.assign(player_count, INITIAL_RATING);
+        rd.assign(player_count, INITIAL_DEVIATION);
+        met.assign((size_t)player_count * player_count, 0);
+        n = player_count;
+    }
+
+    double rating(int player) const { return r[player]; }
+    double deviation(int player) const { return rd[player]; }
+    // 95% 置信区间的半宽
+    double interval(int player) const { return 1.96 * rd[player]; }
+
+    // 一桌打完：players 为本桌三人，score 为各自在本桌的得分
+    void update(const int players[3], const long long score[3]) {
+        double next_r[3], next_rd[3];
+        for (int a = 0; a < 3; a++) {
+            int i = players[a];
+            double info = 0, gain = 0;
+            for (int b = 0; b < 3; b++) {
+                if (b == a) continue;
+                int j = players[b];
+                double gj = g(rd[j]), e = expect(i, j);
+                double s = score[a] > score[b] ? 1 : score[a] == score[b] ? 0.5 : 0;
+                info += Q * Q * gj * gj * e * (1 - e);
+                gain += gj * (s - e);
+            }
+            double precision = 1 / (rd[i] * rd[i]) + info;
+            next_r[a] = r[i] + Q / precision * gain;
+            next_rd[a] = std::sqrt(1 / precision);
+        }
+        for (int a = 0; a < 3; a++) {
+            r[players[a]] = next_r[a];
+            rd[players[a]] = next_rd[a];
+            for (int b = 0; b < 3; b++)
+                if (b != a) met[(size_t)players[a] * n + players[b]]++;
+        }
+    }
+
+    // 按评分从高到低排列的玩家 id，同分按 id
+    std::vector<int> ranking() const {
+        std::vector<int> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](int a, int b) { return r[a] > r[b]; });
+        return order;
+    }
+
+    // 前 k 名的顺序 (含第 k 名与第 k + 1 名之间) 是否在 confidence 水平下都已分出高低；
+    // 相邻两名的评分差按正态近似做单侧检验，k 次比较用 Bonferroni 校正
+    bool settled(int k, double confidence) const {
+        k = std::min(k, n - 1);
+        if (k <= 0) return false;
+        double z = normal_quantile(1 - (1 - confidence) / k);
+        std::vector<int> order = ranking();
+        for (int a = 0; a < k; a++) {
+            int i = order[a], j = order[a + 1];
+            if (r[i] - r[j] < z * std::sqrt(rd[i] * rd[i] + rd[j] * rd[j])) return false;
+        }
+        return true;
+    }
+
+    // 排出下一轮的座位 (第 t 桌坐 seating[3t..3t+2])，让这一轮的比赛尽量多地减小评分的不确定性：
+    // 从 RD 最大的玩家起，依次为其挑选使评分方差减小最多的两个对手；
+    // 每对玩家已经同桌的次数越多，收益打的折扣越大，避免总是同一批人坐在一起。
+    // RD 相同时的先后和同桌三人的座位随机决定，座位的先后手优势不会集中在某个人身上。
+    template <class Rng>
+    void pair_up(std::vector<int>& seating, Rng& rng) const {
+        std::vector<int> pending(n);
+        std::iota(pending.begin(), pending.end(), 0);
+        std::shuffle(pending.begin(), pending.end(), rng);
+        std::stable_sort(pending.begin(), pending.end(), [this](int a, int b) { return rd[a] > rd[b]; });
+        seating.clear();
+        while (!pending.empty()) {
+            int table[3] = {pending[0], -1, -1};
+            pending.erase(pending.begin());
+            for (int seat = 1; seat < 3 && !pending.empty(); seat++) {
+                size_t best = 0;
+                double best_value = -1;
+                for (size_t c = 0; c < pending.size(); c++) {
+                    double value = 0;
+                    for (int s = 0; s < seat; s++) value += benefit(table[s], pending[c]);
+                    if (value > best_value) {
+                        best_value = value;
+                        best = c;
+                    }
+                }
+                table[seat] = pending[best];
+                pending.erase(pending.begin() + best);
+            }
+            int size = table[2] >= 0 ? 3 : table[1] >= 0 ? 2 : 1;
+            std::shuffle(table, table + size, rng);
+            seating.insert(seating.end(), table, table + size);
+        }
+    }
+
+    template <class Archive>
+    void serialize(Archive& ar) {
+        ar.io(r);
+        ar.io(rd);
+        ar.io(met);
+    }
+
+private:
+    static constexpr double PI = 3.14159265358979323846;
+    static constexpr double Q = 0.0057564627324851142;  // ln(10) / 400
+    int n = 0;
+    std::vector<double> r, rd;
+    std::vector<int> met;  // [i][j]: i 和 j 同桌的次数
+
+    static double g(double deviation) { return 1 / std::sqrt(1 + 3 * Q * Q * deviation * deviation / (PI * PI)); }
+
+    // i 对 j 的期望得分
+    double expect(int i, int j) const { return 1 / (1 + std::pow(10, -g(rd[j]) * (r[i] - r[j]) / 400)); }
+
+    // i 与 j 同桌一次，两人评分方差减小量之和 (按同桌次数打折)
+    double benefit(int i, int j) const {
+        double value = 0;
+        for (int a : {i, j}) {
+            int b = a == i ? j : i;
+            double gb = g(rd[b]), e = expect(a, b);
+            double info = Q * Q * gb * gb * e * (1 - e);
+            double var = rd[a] * rd[a];
+            value += var - 1 / (1 / var + info);
+        }
+        return value / (1 + met[(size_t)i * n + j]);
+    }
+
+    // 标准正态分布的 p 分位数，二分求解
+    static double normal_quantile(double p) {
+        double lo = -10, hi = 10;
+        for (int it = 0; it < 100; it++) {
+            double mid = (lo + hi) / 2;
+            if (0.5 * std::erfc(-mid / std::sqrt(2.0)) < p) lo = mid;
+            else hi = mid;
+        }
+        return (lo + hi) / 2;
+    }
+};
+
+#endif // RATING_H
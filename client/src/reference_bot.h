@@ -0,0 +1,165 @@
+#ifndef REFERENCE_BOT_H
+#define REFERENCE_BOT_H
+
+// 内置的参考 bot：只出合法牌的贪心打法，编译在引擎里，default_bot 写 REFERENCE_BOT 即可使用。
+// 按插件 ABI (bot_plugin.h) 实现，与 bot_dir 下的插件走同一条调用路径；没有状态，不申请内存。
+//   叫分: 按 2、王和炸弹的个数估计手牌强度
+//   首出: 能一手出完就出完；否则从最小的点数出起，能组成顺子/连对就出最长的，三张带最小的单张或对子
+//   跟牌: 同牌型中刚好压过的最小一手；队友的牌不压；同牌型压不过时，对手快出完了才用炸弹/火箭
+
+#include "bot_plugin.h"
+#include "moves.h"
+
+constexpr const char* REFERENCE_BOT = "builtin:greedy";
+
+namespace reference_bot {
+
+// 点数 level 中最小的 n 张
+inline uint64_t lowest(CardSet hand, int level, int n) {
+    uint64_t bits = hand.mask() & LEVEL_MASK[level], out = 0;
+    for (int i = 0; i < n && bits; i++) {
+        out |= bits & (~bits + 1);
+        bits &= bits - 1;
+    }
+    return out;
+}
+
+// 给主体 mains (点数集合) 配 count 份带牌，每份是另一个点数的 n 张；
+// 先用恰好 n 张的点数，不够时再拆更多张的点数，凑不齐返回 0
+inline uint64_t kicks(CardSet hand, unsigned mains, int n, int count) {
+    uint64_t out = 0;
+    unsigned used = mains;
+    for (int exact = 1; exact >= 0 && count > 0; exact--) {
+        for (int level = 0; level < LEVEL_COUNT && count > 0; level++) {
+            int have = hand.count(level);
+            if (used >> level & 1 || have < n || (exact && have != n)) continue;
+            out |= lowest(hand, level, n);
+            used |= 1u << level;
+            count--;
+        }
+    }
+    return count ? 0 : out;
+}
+
+// 主体每个点数 main 张、从 level 起连续 length 个点数、带牌方式为 kick 的一手，凑不出返回 0
+inline uint64_t build(CardSet hand, int main, int level, int length, int kick) {
+    if (length > 1 && level + length > 12) return 0;
+    uint64_t cards = 0;
+    unsigned mains = 0;
+    for (int l = level; l < level + length; l++) {
+        if (l >= LEVEL_COUNT || hand.count(l) < main) return 0;
+        cards |= lowest(hand, l, main);
+        mains |= 1u << l;
+    }
+    if (kick) {
+        uint64_t k = kicks(hand, mains, kick, length * KICKS_PER_MAIN[main]);
+        if (!k) return 0;
+        cards |= k;
+    }
+    return cards;
+}
+
+// 牌型对应的主体张数和带牌方式
+inline bool shape(ComboType type, int& main, int& kick) {
+    for (main = 1; main <= 4; main++)
+        for (kick = 0; kick <= 2; kick++)
+            if (SOLO_TYPE[main][kick] == type || CHAIN_TYPE[main][kick] == type) return true;
+    return false;
+}
+
+inline int bid(CardSet own, const int32_t* bids, int bid_count) {
+    int strength = own.count(12) + own.count(13) + 2 * own.count(14);
+    for (int level = 0; level < 13; level++)
+        if (own.count(level) == 4) strength += 2;
+    int want = strength >= 7 ? 3 : strength >= 5 ? 2 : strength >= 4 ? 1 : 0;
+    for (int i = 0; i < bid_count; i++)
+        if (bids[i] >= want) return 0;  // 叫分必须高于之前的叫分
+    return want;
+}
+
+inline uint64_t lead(CardSet own) {
+    if (classify(own).type != INVALID) return own.mask();
+    for (int level = 0; level < LEVEL_COUNT; level++) {
+        int have = own.count(level);
+        if (have == 0 || have == 4) continue;  // 不拆炸弹
+        for (int length = 12 - level; length >= 5; length--)
+            if (uint64_t s = build(own, 1, level, length, 0)) return s;
+        if (have >= 2)
+            for (int length = 12 - level; length >= 3; length--)
+                if (uint64_t s = build(own, 2, level, length, 0)) return s;
+        if (have == 3) {
+            for (int kick = 1; kick <= 2; kick++)
+                if (uint64_t s = build(own, 3, level, 1, kick)) return s;
+        }
+        return lowest(own, level, have);
+    }
+    // 只剩炸弹和火箭
+    for (int level = 0; level < 13; level++)
+        if (own.count(level) == 4) return lowest(own, level, 4);
+    return own.mask() & (3ULL << 52);
+}
+
+// 压过 target 的最小一手，压不过返回 0；bombs 为 false 时不改用炸弹/火箭
+inline uint64_t follow(CardSet own, CardSet target, bool bombs) {
+    Combo want = classify(target);
+    Combo all = classify(own);
+    if (all.type != INVALID && beats(all, want)) return own.mask();
+    int main, kick;
+    if (want.type != ROCKET && want.type != BOMB && shape(want.type, main, kick)) {
+        for (int level = want.level + 1; level < LEVEL_COUNT; level++) {
+            // 不拆炸弹去压非炸弹的牌
+            bool breaks_bomb = false;
+            for (int l = level; l < level + want.length && l < LEVEL_COUNT; l++)
+                if (own.count(l) == 4) breaks_bomb = true;
+            if (breaks_bomb) continue;
+            uint64_t cards = build(own, main, level, want.length, kick);
+            Combo c = classify(CardSet(cards));
+            if (cards && c.size == want.size && beats(c, want)) return cards;
+        }
+    }
+    if (!bombs || want.type == ROCKET) return 0;
+    for (int level = want.type == BOMB ? want.level + 1 : 0; level < 13; level++)
+        if (own.count(level) == 4) return lowest(own, level, 4);
+    if (own.contains(52) && own.contains(53)) return 3ULL << 52;
+    return 0;
+}
+
+inline uint64_t play(const bf_play_request& req) {
+    CardSet own(req.own);
+    CardSet target(req.history[1] ? req.history[1] : req.history[0]);
+    if (target.empty()) return lead(own);
+    // 最后出牌的座位: 上家，上家过牌时为上上家
+    int last = req.history[1] ? (req.pos + 2) % 3 : (req.pos + 1) % 3;
+    bool partner = req.pos != req.landlord && last != req.landlord;
+    int threat = 20;  // 对手中最少的剩余张数
+    for (int i = 0; i < 3; i++) {
+        bool opponent = i != req.pos && (req.pos == req.landlord || i == req.landlord);
+        if (opponent && req.remaining[i] < threat) threat = req.remaining[i];
+    }
+    if (partner) {
+        Combo all = classify(own);
+        return all.type != INVALID && beats(all, classify(target)) ? own.mask() : 0;
+    }
+    return follow(own, target, threat <= 5);
+}
+
+inline void* init() {
+    static int instance;
+    return &instance;
+}
+inline void reset(void*) {}
+inline int32_t bid_entry(void*, const bf_bid_request* req) { return bid(CardSet(req->own), req->bids, req->bid_count); }
+inline uint64_t play_entry(void*, const bf_play_request* req) { return play(*req); }
+inline void destroy(void*) {}
+
+} // namespace reference_bot
+
+inline const bf_plugin* reference_plugin() {
+    static const bf_plugin plugin = {
+        BOTFIELD_ABI_VERSION, "greedy",
+        reference_bot::init, reference_bot::reset, reference_bot::bid_entry, reference_bot::play_entry, reference_bot::destroy,
+    };
+    return &plugin;
+}
+
+#endif // REFERENCE_BOT_H
@@ -0,0 +1,203 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+// 二进制对局记录 (只追加)
+// 文件 = ReplayHeader + 若干局，每局 = ReplayGame (64 字节) + play_count 个出牌掩码 (每个 8 字节)
+// 出牌从地主开始按座位轮流记录，第 i 手由座位 (landlord + i) % 3 打出，过牌的掩码为 0。
+// 一局通常几十手，约 0.5 KB，一百万局约 500 MB。
+// 写入：每个工作线程一个 ReplayWriter，先写进自己的缓冲区，攒满再一次写入文件，不需要加锁。
+// 读取：ReplayReader 把整个文件映射到内存，按顺序遍历，记录直接指向映射的内存。
+// 所有整数按小端序存储 (与引擎运行的 x86/ARM 平台一致)。
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+constexpr uint32_t REPLAY_MAGIC = 0x50524642;  // "BFRP"
+constexpr uint32_t REPLAY_VERSION = 1;
+constexpr uint8_t REPLAY_NONE = 0xFF;  // 没有叫分 / 没有赢家 / 没有判负
+
+struct ReplayHeader {
+    uint32_t magic = REPLAY_MAGIC;
+    uint32_t version = REPLAY_VERSION;
+    uint32_t game_size = 0;  // sizeof(ReplayGame)，读取时用来检查格式
+    uint32_t reserved = 0;
+};
+
+struct ReplayGame {
+    uint32_t game_no;     // 第几轮
+    uint16_t players[3];  // 各座位的玩家 id
+    uint8_t rotation;     // duplicate 模式下的座位排列编号
+    uint8_t bids[3];      // 各座位的叫分，没有叫分为 REPLAY_NONE
+    uint8_t landlord;     // 地主座位
+    uint8_t winner;       // 出完牌的座位，没有为 REPLAY_NONE
+    uint8_t forfeit;      // 判负的座位，没有为 REPLAY_NONE
+    uint8_t reserved0[3];
+    int32_t score;        // 本局的倍数 (地主得 2 * score 或付 2 * score)
+    uint16_t play_count;  // 之后的出牌掩码个数
+    uint16_t reserved1;
+    uint32_t reserved2;
+    uint64_t hands[3];    // 各座位发到的 17 张牌
+    uint64_t publics;     // 3 张底牌
+
+    const uint64_t* plays() const { return reinterpret_cast<const uint64_t*>(this + 1); }
+    size_t bytes() const { return sizeof(ReplayGame) + play_count * sizeof(uint64_t); }
+};
+static_assert(sizeof(ReplayGame) == 64, "ReplayGame layout changed");
+
+class ReplayWriter {
+public:
+    ReplayWriter() = default;
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+    ~ReplayWriter() { close(); }
+
+    // 以追加方式打开，新文件先写入文件头
+    bool open(const std::string& path) {
+        close();
+        file = fopen(path.c_str(), "ab");
+        if (!file) return false;
+        // 缓冲由 buffer 自己管理
+        setvbuf(file, NULL, _IONBF, 0);
+        fseek(file, 0, SEEK_END);
+        if (ftell(file) == 0) {
+            ReplayHeader header;
+            header.game_size = sizeof(ReplayGame);
+            append(&header, sizeof(header));
+        }
+        return true;
+    }
+
+    bool is_open() const { return file != nullptr; }
+
+    void write(const ReplayGame& game, const uint64_t* plays) {
+        if (!file) return;
+        append(&game, sizeof(game));
+        append(plays, game.play_count * sizeof(uint64_t));
+    }
+
+    void flush() {
+        if (file && !buffer.empty()) fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+
+    void close() {
+        if (!file) return;
+        flush();
+        fclose(file);
+        file = nullptr;
+    }
+
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+    FILE* file = nullptr;
+    std::vector<char> buffer;
+
+    void append(const void* data, size_t n) {
+        if (buffer.capacity() < BUFFER_SIZE) buffer.reserve(BUFFER_SIZE);
+        if (buffer.size() + n > BUFFER_SIZE) flush();
+        buffer.insert(buffer.end(), (const char*)data, (const char*)data + n);
+    }
+};
+
+class ReplayReader {
+public:
+    ReplayReader() = default;
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+    ~ReplayReader() { close(); }
+
+    // 映射文件并检查文件头，失败时 error() 给出原因
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+        if (file == INVALID_HANDLE_VALUE) return fail("cannot open file");
+        LARGE_INTEGER n;
+        GetFileSizeEx(file, &n);
+        size = (size_t)n.QuadPart;
+        if (size > 0) {
+            mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (!mapping) return fail("cannot map file");
+            data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return fail("cannot open file");
+        struct stat st;
+        fstat(fd, &st);
+        size = st.st_size;
+        if (size > 0) {
+            void* p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data = (const char*)p;
+                madvise(p, size, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+#endif
+        if (size > 0 && !data) return fail("cannot map file");
+        ReplayHeader header;
+        if (size < sizeof(header)) return fail("file too short");
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != REPLAY_MAGIC) return fail("not a replay file");
+        if (header.version != REPLAY_VERSION || header.game_size != sizeof(ReplayGame)) return fail("unsupported replay version");
+        offset = sizeof(header);
+        return true;
+    }
+
+    // 下一局，读完 (或遇到写了一半的记录) 时返回 nullptr
+    const ReplayGame* next() {
+        if (!data || offset + sizeof(ReplayGame) > size) return nullptr;
+        const ReplayGame* game = reinterpret_cast<const ReplayGame*>(data + offset);
+        if (offset + game->bytes() > size) return nullptr;
+        offset += game->bytes();
+        return game;
+    }
+
+    void rewind() { offset = sizeof(ReplayHeader); }
+
+    const std::string& error() const { return message; }
+
+    void close() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap((void*)data, size);
+#endif
+        data = nullptr;
+        size = offset = 0;
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+    std::string message;
+
+    bool fail(const char* reason) {
+        close();
+        message = reason;
+        return false;
+    }
+};
+
+#endif // REPLAY_H
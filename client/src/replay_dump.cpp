@@ -0,0 +1,71 @@
+//Chinese UTF-8
+// 对局记录导出工具：把 .bfr 文件中的每一局输出为一行 JSON
+// 用法: replay_dump <file.bfr>...
+#include <iostream>
+#include <sstream>
+#include "cards.h"
+#include "replay.h"
+
+using namespace std;
+
+static void put_cards(ostream& out, uint64_t mask)
+{
+	out << '[';
+	bool first = true;
+	for (short card : CardSet(mask))
+	{
+		if (!first) out << ',';
+		out << card;
+		first = false;
+	}
+	out << ']';
+}
+
+static int seat_or_null(uint8_t seat) { return seat == REPLAY_NONE ? -1 : seat; }
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		cerr << "usage: " << argv[0] << " <file.bfr>..." << endl;
+		return 1;
+	}
+	ios::sync_with_stdio(false);
+	int status = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		ReplayReader reader;
+		if (!reader.open(argv[i]))
+		{
+			cerr << argv[i] << ": " << reader.error() << endl;
+			status = 1;
+			continue;
+		}
+		while (const ReplayGame* game = reader.next())
+		{
+			ostringstream out;
+			out << "{\"game_no\":" << game->game_no << ",\"rotation\":" << (int)game->rotation << ",\"players\":["
+			    << game->players[0] << ',' << game->players[1] << ',' << game->players[2] << "],\"hands\":[";
+			for (int s = 0; s < 3; s++)
+			{
+				if (s) out << ',';
+				put_cards(out, game->hands[s]);
+			}
+			out << "],\"publiccard\":";
+			put_cards(out, game->publics);
+			out << ",\"bids\":[";
+			for (int s = 0; s < 3; s++) out << (s ? "," : "") << seat_or_null(game->bids[s]);
+			out << "],\"landlord\":" << seat_or_null(game->landlord) << ",\"plays\":[";
+			const uint64_t* plays = game->plays();
+			for (int k = 0; k < game->play_count; k++)
+			{
+				if (k) out << ',';
+				put_cards(out, plays[k]);
+			}
+			out << "],\"winner\":" << seat_or_null(game->winner) << ",\"forfeit\":" << seat_or_null(game->forfeit)
+			    << ",\"score\":" << game->score << "}\n";
+			cout << out.str();
+		}
+	}
+	return status;
+}
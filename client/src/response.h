@@ -0,0 +1,276 @@
+#ifndef RESPONSE_H
+#define RESPONSE_H
+
+// bot 输出的解析：引擎只需要 {"response": ...} 中的一个整数 (叫分) 或一组牌的编号 (出牌)，
+// 这里直接在读到的输出上逐字节扫描，不构造 JSON 树，不申请内存。
+// 其他字段 (debug、data、globaldata 等) 按 JSON 语法跳过，不看内容。
+// 格式错误时给出原因和出错的字节位置；与 jsoncpp 一样读完第一个完整的顶层对象即结束，之后的内容 (调试输出等) 忽略。
+// 与 jsoncpp 一致，写成 2.0、2e0 这样值为整数的数字也当作整数。
+
+#include <cctype>
+#include <climits>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include "cards.h"
+
+struct Response {
+    enum Kind {
+        MISSING,  // 没有 response 字段
+        NUMBER,   // 整数
+        CARDS,    // 整数数组
+        OTHER,    // 其他类型的值 (包括含有非整数元素的数组)
+    };
+    Kind kind = MISSING;
+    long long number = 0;    // NUMBER: 值，超出范围时取最接近的 long long
+    CardSet cards;           // CARDS: 牌
+    bool bad_card = false;   // CARDS: 有不在 0..53 内的编号或重复的牌
+    const char* error = nullptr;  // 格式错误的原因，为空表示格式正确
+    size_t offset = 0;            // 出错的字节位置
+};
+
+class ResponseParser {
+public:
+    // 解析整个输出，格式错误时返回 false，原因见 out.error
+    static bool parse(std::string_view text, Response& out) {
+        ResponseParser p(text, out);
+        return p.document();
+    }
+
+private:
+    static constexpr int MAX_DEPTH = 64;
+    const char* begin;
+    const char* p;
+    const char* end;
+    Response& out;
+
+    ResponseParser(std::string_view text, Response& r) : begin(text.data()), p(text.data()), end(text.data() + text.size()), out(r) {}
+
+    bool fail(const char* what) {
+        out.error = what;
+        out.offset = p - begin;
+        return false;
+    }
+
+    void skip_space() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    }
+
+    bool document() {
+        skip_space();
+        if (p == end) return fail("empty output");
+        if (*p != '{') return fail("expected '{'");
+        p++;
+        skip_space();
+        if (p < end && *p == '}') p++;
+        else {
+            for (;;) {
+                skip_space();
+                std::string_view key;
+                if (!string(key)) return false;
+                skip_space();
+                if (p == end || *p != ':') return fail("expected ':'");
+                p++;
+                skip_space();
+                if (key == "response") {
+                    if (out.kind != Response::MISSING) return fail("duplicate response");
+                    if (!response()) return false;
+                }
+                else if (!skip_value(0)) return false;
+                skip_space();
+                if (p < end && *p == ',') {
+                    p++;
+                    continue;
+                }
+                if (p < end && *p == '}') {
+                    p++;
+                    break;
+                }
+                return fail("expected ',' or '}'");
+            }
+        }
+        return true;
+    }
+
+    bool response() {
+        if (p < end && (*p == '-' || (*p >= '0' && *p <= '9'))) {
+            bool integral;
+            if (!number(integral, out.number)) return false;
+            out.kind = integral ? Response::NUMBER : Response::OTHER;
+            return true;
+        }
+        if (p == end || *p != '[') {
+            out.kind = Response::OTHER;
+            return skip_value(0);
+        }
+        p++;
+        out.kind = Response::CARDS;
+        skip_space();
+        if (p < end && *p == ']') {
+            p++;
+            return true;
+        }
+        for (;;) {
+            skip_space();
+            if (p < end && (*p == '-' || (*p >= '0' && *p <= '9'))) {
+                bool integral;
+                long long card;
+                if (!number(integral, card)) return false;
+                if (!integral) out.kind = Response::OTHER;
+                else if (card < 0 || card >= CARD_COUNT || out.cards.contains(card)) out.bad_card = true;
+                else out.cards.insert(card);
+            }
+            else {
+                out.kind = Response::OTHER;
+                if (!skip_value(1)) return false;
+            }
+            skip_space();
+            if (p < end && *p == ',') {
+                p++;
+                continue;
+            }
+            if (p < end && *p == ']') {
+                p++;
+                return true;
+            }
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    // 字符串，raw 为引号之间未转义的原文
+    bool string(std::string_view& raw) {
+        if (p == end || *p != '"') return fail("expected string");
+        const char* first = ++p;
+        while (p < end && *p != '"') {
+            if ((unsigned char)*p < 0x20) return fail("control character in string");
+            if (*p++ != '\\') continue;
+            if (p == end) break;
+            char c = *p++;
+            if (c == 'u') {
+                for (int i = 0; i < 4; i++, p++)
+                    if (p == end || !isxdigit((unsigned char)*p)) return fail("bad \\u escape");
+            }
+            else if (!strchr("\"\\/bfnrt", c) || c == 0) {
+                p--;
+                return fail("bad escape");
+            }
+        }
+        if (p == end) return fail("unterminated string");
+        raw = std::string_view(first, p - first);
+        p++;
+        return true;
+    }
+
+    // JSON 数字；integral 表示值是否为整数
+    bool number(bool& integral, long long& value) {
+        const char* first = p;
+        bool negative = p < end && *p == '-';
+        if (negative) p++;
+        if (p == end || *p < '0' || *p > '9') return fail("bad number");
+        bool overflow = false;
+        value = 0;
+        if (*p == '0') p++;
+        else
+            while (p < end && *p >= '0' && *p <= '9') {
+                int d = *p++ - '0';
+                if (value > (LLONG_MAX - d) / 10) overflow = true;
+                else value = value * 10 + d;
+            }
+        bool fraction = false;
+        if (p < end && *p == '.') {
+            p++;
+            if (p == end || *p < '0' || *p > '9') return fail("bad number");
+            while (p < end && *p >= '0' && *p <= '9') fraction |= *p++ != '0';
+        }
+        bool exponent = p < end && (*p == 'e' || *p == 'E');
+        if (exponent) {
+            p++;
+            if (p < end && (*p == '+' || *p == '-')) p++;
+            if (p == end || *p < '0' || *p > '9') return fail("bad number");
+            while (p < end && *p >= '0' && *p <= '9') p++;
+        }
+        if (overflow) value = LLONG_MAX;
+        if (negative) value = -value;
+        integral = !fraction;
+        if (exponent) {
+            // 少见的写法，按浮点数求值
+            char buf[40];
+            size_t n = p - first;
+            if (n >= sizeof(buf)) {
+                integral = false;
+                return true;
+            }
+            memcpy(buf, first, n);
+            buf[n] = 0;
+            double d = strtod(buf, nullptr);
+            integral = d > -9.2e18 && d < 9.2e18 && d == (double)(long long)d;
+            if (integral) value = (long long)d;
+        }
+        return true;
+    }
+
+    bool literal(const char* word) {
+        size_t n = strlen(word);
+        if ((size_t)(end - p) < n || memcmp(p, word, n) != 0) return fail("unexpected character");
+        p += n;
+        return true;
+    }
+
+    // 跳过任意一个值
+    bool skip_value(int depth) {
+        if (depth > MAX_DEPTH) return fail("nesting too deep");
+        if (p == end) return fail("unexpected end of output");
+        switch (*p) {
+        case '"': {
+            std::string_view raw;
+            return string(raw);
+        }
+        case 't': return literal("true");
+        case 'f': return literal("false");
+        case 'n': return literal("null");
+        case '[':
+        case '{': {
+            char close = *p == '[' ? ']' : '}';
+            bool object = close == '}';
+            p++;
+            skip_space();
+            if (p < end && *p == close) {
+                p++;
+                return true;
+            }
+            for (;;) {
+                skip_space();
+                if (object) {
+                    std::string_view key;
+                    if (!string(key)) return false;
+                    skip_space();
+                    if (p == end || *p != ':') return fail("expected ':'");
+                    p++;
+                    skip_space();
+                }
+                if (!skip_value(depth + 1)) return false;
+                skip_space();
+                if (p < end && *p == ',') {
+                    p++;
+                    continue;
+                }
+                if (p < end && *p == close) {
+                    p++;
+                    return true;
+                }
+                return fail(object ? "expected ',' or '}'" : "expected ',' or ']'");
+            }
+        }
+        default:
+            if (*p == '-' || (*p >= '0' && *p <= '9')) {
+                bool integral;
+                long long value;
+                return number(integral, value);
+            }
+            return fail("unexpected character");
+        }
+    }
+};
+
+#endif // RESPONSE_H
@@ -0,0 +1,195 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// 基于 epoll 的多桌调度器 (仅 POSIX)
+// 每一桌都是一个 Table 状态机，所有 bot 的输出管道由同一个事件循环等待，
+// 等待 bot 思考时不占用引擎线程，同时进行的桌数只受 max_inflight 限制。
+// 有时间限制时，每个等待中的决策在最早可能超限的时刻挂一个定时器，epoll_wait 的超时取最近的定时器。
+
+#ifndef _WIN32
+#include <string>
+#include <vector>
+#include <memory>
+#include <queue>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include "table.h"
+#include "bot_process.h"
+
+// Job 需要有成员 Table table
+template <class Job>
+class TableScheduler {
+public:
+    std::function<Decision(Job&)> launch;  // 发起 job.table.turn 座位的一次决策
+    // 一次决策结束，把结果交给 job.table；overrun 非空表示超限，进程已被结束
+    std::function<void(Job&, const Decision&, const std::string& output, const char* overrun)> complete;
+    std::function<bool(Job&)> finish;      // 一局结束；在同一桌上开始了下一局时返回 true
+    size_t max_inflight = 0;               // 同时进行的桌数上限，0 表示不限制
+    Limits limits;                         // 每次决策的限制
+
+    TableScheduler() {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        // 每桌同时最多占用两个管道，尽量放开描述符上限
+        rlimit lim;
+        if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max) {
+            lim.rlim_cur = lim.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &lim);
+        }
+    }
+    ~TableScheduler() { close(epfd); }
+
+    // next() 给出下一桌可以开始的比赛，暂时没有时返回 nullptr；
+    // 新的比赛可以在 finish 中变得可以开始，没有进行中的桌且 next() 没有比赛时返回
+    void run(const std::function<Job*()>& next) {
+        // slot 在整个 run 期间有效，过期的定时器和事件可以安全地找到它们
+        std::deque<Slot> slots;
+        timers = {};
+        std::vector<Slot*> free_slots;
+        size_t inflight = 0;
+        std::vector<epoll_event> events(256);
+        for (;;) {
+            while (max_inflight == 0 || inflight < max_inflight) {
+                Job* job = next();
+                if (!job) break;
+                if (free_slots.empty()) {
+                    slots.emplace_back();
+                    free_slots.push_back(&slots.back());
+                }
+                Slot* slot = free_slots.back();
+                free_slots.pop_back();
+                slot->job = job;
+                inflight++;
+                if (!dispatch(slot)) {
+                    inflight--;
+                    free_slots.push_back(slot);
+                }
+            }
+            if (inflight == 0) break;
+            int n = epoll_wait(epfd, events.data(), (int)events.size(), wait_timeout());
+            for (int i = 0; i < n; i++) {
+                Slot* slot = static_cast<Slot*>(events[i].data.ptr);
+                std::string output;
+                if (!collect(slot, output)) {
+                    arm(slot, EPOLL_CTL_MOD);
+                    continue;
+                }
+                slot->waiting = false;
+                complete(*slot->job, slot->decision, output, nullptr);
+                if (!dispatch(slot)) {
+                    inflight--;
+                    free_slots.push_back(slot);
+                }
+            }
+            inflight -= expire(free_slots);
+        }
+    }
+
+private:
+    using Clock = BotProcess::Clock;
+
+    struct Slot {
+        Job* job = nullptr;
+        Decision decision;
+        int fd = -1;
+        unsigned serial = 0;   // 第几次决策，用来识别过期的定时器
+        bool waiting = false;  // 正在等待 bot 输出
+    };
+
+    // 到时检查一次决策是否超限
+    struct Timer {
+        Clock::time_point when;
+        Slot* slot;
+        unsigned serial;
+        bool operator>(const Timer& other) const { return when > other.when; }
+    };
+
+    int epfd;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+
+    // 发起下一次决策并开始等待；本桌结束时返回 false
+    // finish 在同一个 job 上开始了新的一局时接着驱动
+    bool dispatch(Slot* slot) {
+        Table& table = slot->job->table;
+        for (;;) {
+            if (table.finished() && !finish(*slot->job)) return false;
+            slot->decision = launch(*slot->job);
+            if (slot->decision.done) continue;
+            std::string output;
+            if (slot->decision.proc && !collect(slot, output)) {
+                slot->fd = slot->decision.proc->out_fd();
+            }
+            else {
+                // 启动失败或之前已经读到了完整的一行
+                complete(*slot->job, slot->decision, output, nullptr);
+                continue;
+            }
+            // 常驻进程的管道可能仍留在等待集合中 (已被 EPOLLONESHOT 停用)
+            if (!arm(slot, EPOLL_CTL_ADD) && errno == EEXIST) arm(slot, EPOLL_CTL_MOD);
+            slot->serial++;
+            slot->waiting = true;
+            schedule(slot);
+            return true;
+        }
+    }
+
+    void schedule(Slot* slot) {
+        Clock::time_point when = slot->decision.proc->next_check(limits);
+        if (when != Clock::time_point::max()) timers.push({when, slot, slot->serial});
+    }
+
+    int wait_timeout() const {
+        if (timers.empty()) return -1;
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(timers.top().when - Clock::now()).count();
+        return (int)std::max<long long>(left, 0);
+    }
+
+    // 处理到期的定时器，超限的决策结束进程并判负；返回因此结束的桌数
+    size_t expire(std::vector<Slot*>& free_slots) {
+        size_t done = 0;
+        Clock::time_point now = Clock::now();
+        while (!timers.empty() && timers.top().when <= now) {
+            Timer timer = timers.top();
+            timers.pop();
+            Slot* slot = timer.slot;
+            if (timer.serial != slot->serial || !slot->waiting) continue;
+            BotProcess* proc = slot->decision.proc;
+            const char* reason = proc->overrun(limits);
+            if (!reason) {
+                schedule(slot);
+                continue;
+            }
+            // 先移出等待集合：尚未 exec 的子进程可能还持有这个管道
+            epoll_ctl(epfd, EPOLL_CTL_DEL, slot->fd, nullptr);
+            proc->stop();
+            slot->waiting = false;
+            complete(*slot->job, slot->decision, std::string(), reason);
+            if (!dispatch(slot)) {
+                done++;
+                free_slots.push_back(slot);
+            }
+        }
+        return done;
+    }
+
+    // 每次只等待一个事件：fork 出的子进程在 exec 前会短暂持有管道，
+    // 此时 close() 不会把描述符移出 epoll，一次性等待保证已完成的决策不会再触发事件
+    bool arm(Slot* slot, int op) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.ptr = slot;
+        return epoll_ctl(epfd, op, slot->fd, &ev) == 0;
+    }
+
+    // 读取就绪的输出；决策完成时返回 true
+    bool collect(Slot* slot, std::string& output) {
+        return slot->decision.proc->try_read(output, slot->decision.until_eof);
+    }
+};
+#endif
+
+#endif // SCHEDULER_H
@@ -0,0 +1,193 @@
+#ifndef SCOREBOARD_H
+#define SCOREBOARD_H
+
+// 成绩表：玩家用 0..n-1 的整数 id 索引
+// 每个进行中的轮次有自己的一份增量 (按 slot 索引)，一轮之内各桌的玩家互不相同，
+// 写入不需要加锁；一轮全部打完后再合并进总成绩。
+// 每条记录独占一个缓存行，不同桌、不同轮次之间不会争用同一缓存行。
+
+#include <vector>
+#include <array>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+
+// 决策耗时的直方图 (微秒)：按 2 的幂分段，每段再等分 SUB 份，分位数的相对误差不超过 1/SUB
+class LatencyHistogram {
+public:
+    void add(double us) {
+        counts[bucket(us < 0 ? 0 : (unsigned long long)us)]++;
+        total++;
+    }
+
+    void add(const LatencyHistogram& other) {
+        for (int i = 0; i < BUCKETS; i++) counts[i] += other.counts[i];
+        total += other.total;
+    }
+
+    long long size() const { return total; }
+
+    // 依次给出非零的分段 (编号, 个数)，用于跨进程合并；分段 b 的中点见 middle()
+    template <class F>
+    void for_each_bucket(F&& f) const {
+        for (int i = 0; i < BUCKETS; i++)
+            if (counts[i]) f(i, counts[i]);
+    }
+
+    // 只存非零的分段 (编号, 个数)
+    template <class Archive>
+    void serialize(Archive& ar) {
+        uint16_t used = 0;
+        for_each_bucket([&](int, unsigned) { used++; });
+        ar.io(used);
+        if constexpr (Archive::loading) {
+            counts.fill(0);
+            for (int k = 0; k < used; k++) {
+                uint16_t b = 0;
+                unsigned count = 0;
+                ar.io(b);
+                ar.io(count);
+                if (b < BUCKETS) counts[b] = count;
+            }
+        } else {
+            for (uint16_t b = 0; b < BUCKETS; b++)
+                if (counts[b]) {
+                    ar.io(b);
+                    ar.io(counts[b]);
+                }
+        }
+        ar.io(total);
+    }
+
+    // 分位数 q (0..1)，取所在区间的中点，单位毫秒
+    double quantile(double q) const {
+        long long rank = std::max(1LL, (long long)(q * total + 0.999999));
+        for (int i = 0; i < BUCKETS; i++) {
+            if ((rank -= counts[i]) <= 0) return middle(i) / 1000;
+        }
+        return 0;
+    }
+
+private:
+    static constexpr int SUB = 8;
+    static constexpr int BUCKETS = 40 * SUB;
+    std::array<unsigned, BUCKETS> counts = {};
+    long long total = 0;
+
+    static int bucket(unsigned long long us) {
+        if (us < SUB) return (int)us;
+        int e = 63 - __builtin_clzll(us);
+        return std::min((e - 2) * SUB + (int)((us >> (e - 3)) & (SUB - 1)), BUCKETS - 1);
+    }
+
+    static double middle(int b) {
+        if (b < SUB) return b;
+        int e = b / SUB + 2;
+        double width = (double)(1ULL << (e - 3));
+        return (SUB + b % SUB) * width + width / 2;
+    }
+};
+
+struct alignas(64) PlayerScore {
+    long long score = 0;
+    int wins = 0;
+    int forfeits = 0;  // 因非法叫分/出牌或超限被判负的局数
+    int timeouts = 0;  // 超出时间限制的决策数
+    double cpu_ms = 0;     // 全部决策的 CPU 时间之和
+    long peak_rss_kb = 0;  // 单次决策中见到的最大峰值内存
+    int endgame_decisions = 0;  // 残局分析: 面对必胜局面的出牌数
+    int endgame_blunders = 0;   // 其中把必胜走成必败的次数
+    LatencyHistogram latency;
+
+    void add(const PlayerScore& other) {
+        score += other.score;
+        wins += other.wins;
+        forfeits += other.forfeits;
+        timeouts += other.timeouts;
+        cpu_ms += other.cpu_ms;
+        peak_rss_kb = std::max(peak_rss_kb, other.peak_rss_kb);
+        endgame_decisions += other.endgame_decisions;
+        endgame_blunders += other.endgame_blunders;
+        latency.add(other.latency);
+    }
+
+    // 记录一次决策的资源占用
+    void record(double wall_ms, double cpu, long rss_kb, bool overrun) {
+        latency.add(wall_ms * 1000);
+        cpu_ms += cpu;
+        peak_rss_kb = std::max(peak_rss_kb, rss_kb);
+        if (overrun) timeouts++;
+    }
+
+    long long decisions() const { return latency.size(); }
+
+    template <class Archive>
+    void serialize(Archive& ar) {
+        ar.io(score);
+        ar.io(wins);
+        ar.io(forfeits);
+        ar.io(timeouts);
+        ar.io(cpu_ms);
+        int64_t rss = peak_rss_kb;
+        ar.io(rss);
+        peak_rss_kb = rss;
+        ar.io(endgame_decisions);
+        ar.io(endgame_blunders);
+        latency.serialize(ar);
+    }
+};
+
+class Scoreboard {
+public:
+    void init(int player_count, int slot_count) {
+        players = player_count;
+        total.assign(players, PlayerScore());
+        round.assign(players, 0);
+        partial.assign((size_t)players * slot_count, PlayerScore());
+    }
+
+    // 改变进行中轮次的个数，只能在没有轮次进行时调用；总成绩保持不变
+    void resize(int slot_count) { partial.assign((size_t)players * slot_count, PlayerScore()); }
+
+    // 位于 slot 的轮次的增量
+    PlayerScore& local(int slot, int player) { return partial[(size_t)slot * players + player]; }
+
+    // 把 slot 的增量合并进总成绩并清零，只能在这一轮没有桌写入时调用
+    void merge(int slot) {
+        for (int i = 0; i < players; i++) {
+            PlayerScore& ps = local(slot, i);
+            round[i] = ps.score;
+            total[i].add(ps);
+            ps = PlayerScore();
+        }
+    }
+
+    const PlayerScore& operator[](int player) const { return total[player]; }
+
+    // 最近一次 merge 的得分增量，即这一轮 (duplicate 模式下为这一副牌全部座位排列) 的得分
+    long long last_round(int player) const { return round[player]; }
+
+    // 按总分从高到低排列的玩家 id，同分按 id
+    std::vector<int> ranking() const {
+        std::vector<int> order(players);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+            return total[a].score > total[b].score;
+        });
+        return order;
+    }
+
+    // 检查点只保存总成绩，进行中轮次的增量不保存
+    template <class Archive>
+    void serialize(Archive& ar) {
+        for (PlayerScore& ps : total) ps.serialize(ar);
+    }
+
+private:
+    int players = 0;
+    std::vector<PlayerScore> total;
+    std::vector<PlayerScore> partial;  // [slot][player]
+    std::vector<long long> round;
+};
+
+#endif // SCOREBOARD_H
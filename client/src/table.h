@@ -0,0 +1,260 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+// 一桌对局的状态机：叫分 -> 第一轮出牌 -> 轮流出牌直到有人出完
+// 每一步都在等待座位 turn 的一次决策，决策结果 (bot 的原始输出) 通过 feed() 送回，
+// 因此既可以在线程里阻塞驱动，也可以由事件循环同时驱动很多桌。
+// 每次叫分和出牌都会检查合法性，非法 (包括输出格式错误) 的一方判负，对局立即结束。
+// 进程内插件的座位直接通过 feed_bid()/feed_play() 给出决策，不生成交互记录。
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cstdio>
+#include <string_view>
+#include "cards.h"
+#include "moves.h"
+#include "transcript.h"
+#include "response.h"
+#include "bot_plugin.h"
+
+class Table {
+public:
+    enum Phase { BIDDING, FIRST_ROUND, PLAYING, FINISHED };
+
+    Phase phase = FINISHED;
+    int turn = 0;                           // 当前等待决策的座位
+    CardSet player_cards[3];
+    CardSet initial_cards[3];               // 发到的牌，不含底牌
+    CardSet public_cards;
+    Transcript transcript[3];               // 各座位本局的交互记录，即 bot 的完整输入
+    int player_bid[3] = {};
+    int final_bid = 0;
+    int landlord_position = 0;
+    int score = 1;
+    bool landlord_has_not_played = true;    // 地主除了第一手之外还没出过牌
+    CardSet history[2];                     // history[0]为上上家的出牌记录，history[1]为上家的出牌记录
+    int winner = -1;                        // 出完牌的座位
+    int forfeit = -1;                       // 判负的座位
+    const char* forfeit_reason = nullptr;
+    std::vector<uint64_t> plays;            // 从地主开始按座位轮流的每一手牌，过牌为 0
+    bool native[3] = {};                    // 座位上是进程内插件，不需要交互记录
+
+    void start(const CardSet hands[3], CardSet publics) {
+        arena.reset();
+        for (int i = 0; i < 3; i++) {
+            player_cards[i] = initial_cards[i] = hands[i];
+            player_bid[i] = -1;
+            transcript[i].reset(&arena);
+        }
+        plays.clear();
+        landlord_position = -1;
+        public_cards = publics;
+        history[0].clear();
+        history[1].clear();
+        score = 1;
+        landlord_has_not_played = true;
+        winner = -1;
+        forfeit = -1;
+        forfeit_reason = nullptr;
+        phase = BIDDING;
+        turn = 0;
+        step = 0;
+        request_bid();
+    }
+
+    bool finished() const { return phase == FINISHED; }
+
+    // 座位 turn 的 bot 输出
+    void feed(std::string_view output) {
+        Response response;
+        if (!ResponseParser::parse(output, response)) {
+            snprintf(detail, sizeof(detail), "malformed response (%s at byte %zu)", response.error, response.offset);
+            return lose(turn, detail);
+        }
+        if (phase == BIDDING) {
+            if (response.kind != Response::NUMBER) return lose(turn, "invalid bid");
+            return feed_bid((int)std::clamp(response.number, -1LL, 4LL));
+        }
+
+        // 牌的编号必须是 0..53 且不重复
+        if (response.kind != Response::CARDS) return lose(turn, "malformed response");
+        if (response.bad_card) return lose(turn, "invalid or repeated card");
+        feed_play(response.cards);
+    }
+
+    // 座位 turn 的叫分
+    void feed_bid(int bid) {
+        if (bid < 0 || bid > 3) return lose(turn, "invalid bid");
+        player_bid[turn] = bid;
+        if (!native[turn]) {
+            transcript[turn].begin_response();
+            transcript[turn].put(player_bid[turn]);
+        }
+        if (++step < 3) {
+            turn++;
+            request_bid();
+            return;
+        }
+        landlord_position = 0;
+        if (player_bid[1] > player_bid[0]) {
+            if (player_bid[2] > player_bid[1]) landlord_position = 2;
+            else landlord_position = 1;
+        }
+        else if (player_bid[2] > player_bid[0]) landlord_position = 2;
+        final_bid = *std::max_element(player_bid, player_bid + 3);
+        score = std::max(final_bid, 1);
+        phase = FIRST_ROUND;
+        turn = landlord_position;
+        step = 0;
+        request_play();
+    }
+
+    // 座位 turn 的出牌
+    void feed_play(CardSet play) {
+        if (phase == FIRST_ROUND && step == 0) player_cards[landlord_position].insert(public_cards);
+        Combo combo;
+        if (const char* reason = check_play(player_cards[turn], history, play, combo)) return lose(turn, reason);
+
+        history[0] = history[1];
+        history[1] = play;
+        plays.push_back(play.mask());
+        player_cards[turn].erase(play);
+        if (combo.type == ROCKET || combo.type == BOMB) score *= 2;  // 王炸、炸弹
+        if (phase == PLAYING && turn == landlord_position && !history[1].empty()) landlord_has_not_played = false;
+        if (!native[turn]) {
+            Transcript& out = transcript[turn];
+            out.begin_response();
+            out.put("[", 1);
+            append_cards(out, history[1]);
+            out.put("]", 1);
+        }
+
+        if (player_cards[turn].empty()) {
+            winner = turn;
+            if (turn == landlord_position) {
+                if (player_cards[(turn + 1) % 3].size() == 17 && player_cards[(turn + 2) % 3].size() == 17) score *= 2;  // 地主春天
+            }
+            else if (landlord_has_not_played) score *= 2;  // 农民春天
+            phase = FINISHED;
+            return;
+        }
+        turn = (turn + 1) % 3;
+        if (phase == FIRST_ROUND && ++step == 3) phase = PLAYING;
+        request_play();
+    }
+
+    // 座位 turn 的决策没有结果 (例如超时)，判负
+    void fail(const char* reason) { lose(turn, reason); }
+
+    // 座位 turn 的插件请求 (插件 ABI 见 bot_plugin.h)
+    bf_bid_request bid_request() const {
+        bf_bid_request req = {};
+        req.own = player_cards[turn].mask();
+        req.pos = req.bid_count = turn;
+        for (int i = 0; i < turn; i++) req.bids[i] = player_bid[i];
+        return req;
+    }
+
+    // 假设前面的座位依次叫了 bids[0..seat-1]，把座位 seat 的叫分请求写入空的交互记录 out；
+    // 与实际轮到 seat 时的输入逐字节相同，用于提前启动后面座位的叫分决策
+    void bid_request_for(int seat, const int* bids, Transcript& out) const {
+        write_bid_request(out, player_cards[seat], bids, seat);
+    }
+
+    // req.plays 指向本桌的出牌记录，下一手出牌之前有效
+    bf_play_request play_request() const {
+        bf_play_request req = {};
+        CardSet own = player_cards[turn];
+        if (plays.empty()) own.insert(public_cards);  // 地主的第一手，底牌还没有并入手牌
+        req.own = own.mask();
+        req.publics = public_cards.mask();
+        req.history[0] = history[0].mask();
+        req.history[1] = history[1].mask();
+        req.plays = plays.data();
+        req.play_count = plays.size();
+        req.pos = turn;
+        req.landlord = landlord_position;
+        req.final_bid = final_bid;
+        for (int i = 0; i < 3; i++) req.remaining[i] = player_cards[i].size() + (i == landlord_position && plays.empty() ? 3 : 0);
+        return req;
+    }
+
+    bool landlord_won() const { return winner == landlord_position; }
+
+    // 座位 seat 本局的得分；判负时由判负方一人支付，另外两家各得 score
+    int delta(int seat) const {
+        if (forfeit >= 0) return seat == forfeit ? -2 * score : score;
+        int sign = landlord_won() ? 1 : -1;
+        return seat == landlord_position ? 2 * score * sign : -score * sign;
+    }
+
+    bool won(int seat) const {
+        if (forfeit >= 0) return seat != forfeit;
+        return (seat == landlord_position) == landlord_won();
+    }
+
+private:
+    int step = 0;  // 叫分阶段/第一轮中已经完成的决策数
+    Arena arena;   // 本桌交互记录的内存，每局开始时回收
+    char detail[96] = "";  // 格式错误时的判负原因
+
+    void lose(int seat, const char* reason) {
+        forfeit = seat;
+        forfeit_reason = reason;
+        phase = FINISHED;
+    }
+
+    static void append_cards(Transcript& out, CardSet cards) {
+        bool first = true;
+        for (short card : cards) {
+            if (!first) out.put(",", 1);
+            out.put(card);
+            first = false;
+        }
+    }
+
+    static void write_bid_request(Transcript& out, CardSet own, const int* bids, int count) {
+        out.begin_request();
+        out.put("{\"own\":[");
+        append_cards(out, own);
+        out.put("],\"bid\":[");
+        for (int i = 0; i < count; i++) {
+            if (i) out.put(",", 1);
+            out.put(bids[i]);
+        }
+        out.put("]}");
+    }
+
+    void request_bid() {
+        if (native[turn]) return;
+        write_bid_request(transcript[turn], player_cards[turn], player_bid, turn);
+    }
+
+    void request_play() {
+        if (native[turn]) return;
+        Transcript& out = transcript[turn];
+        out.begin_request();
+        out.put("{\"history\":[[");
+        append_cards(out, history[0]);
+        out.put("],[");
+        append_cards(out, history[1]);
+        out.put("]]");
+        if (phase == FIRST_ROUND) {
+            out.put(",\"own\":[");
+            append_cards(out, player_cards[turn]);
+            out.put("],\"publiccard\":[");
+            append_cards(out, public_cards);
+            out.put("],\"landlord\":");
+            out.put(landlord_position);
+            out.put(",\"pos\":");
+            out.put(turn);
+            out.put(",\"finalbid\":");
+            out.put(final_bid);
+        }
+        out.put("}", 1);
+    }
+};
+
+#endif // TABLE_H
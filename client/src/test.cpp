@@ -0,0 +1,299 @@
+//Chinese UTF-8
+// 引擎规则部分的自检: make test
+// 牌型判断 (classify)、大小比较 (beats)、出牌检查 (check_play)、bot 输出解析 (ResponseParser)，
+// 以及残局求解器的走法生成 (for_each_move) 与 classify、beats 逐一对照。
+// 全部通过时输出 "all tests passed" 并返回 0，否则列出失败的用例并返回 1。
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "cards.h"
+#include "moves.h"
+#include "response.h"
+#include "endgame.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void expect(bool ok, const string& what) {
+    if (ok) return;
+    failures++;
+    cout << "FAIL: " << what << "\n";
+}
+
+// 按点数写牌: 3..9 T J Q K A 2，x 小王，X 大王；同一点数依次取不同花色
+static CardSet parse_cards(const string& text) {
+    static const string LEVELS = "3456789TJQKA2xX";
+    CardSet cards;
+    int used[LEVEL_COUNT] = {};
+    for (char ch : text) {
+        int level = (int)LEVELS.find(ch);
+        cards.insert(level == 14 ? 53 : level * 4 + used[level]++);
+    }
+    return cards;
+}
+
+struct ClassifyCase {
+    const char* cards;
+    ComboType type;
+    int level, length;
+};
+
+static const ClassifyCase CLASSIFY_CASES[] = {
+    {"", PASS, 0, 0},
+    {"3", SINGLE, 0, 1},
+    {"X", SINGLE, 14, 1},
+    {"22", PAIR, 12, 1},
+    {"xX", ROCKET, 13, 1},
+    {"3X", INVALID, 0, 0},
+    {"34567", STRAIGHT, 0, 5},
+    {"TJQKA", STRAIGHT, 7, 5},
+    {"3456789TJQKA", STRAIGHT, 0, 12},
+    {"JQKA2", INVALID, 0, 0},      // 2 不能连
+    {"QKA2x", INVALID, 0, 0},      // 王不能连
+    {"3456", INVALID, 0, 0},
+    {"334455", STRAIGHT2, 0, 3},
+    {"3344", INVALID, 0, 0},
+    {"QQKKAA22", INVALID, 0, 0},
+    {"222", TRIPLET, 12, 1},
+    {"3334", TRIPLET1, 0, 1},
+    {"333x", TRIPLET1, 0, 1},
+    {"33344", TRIPLET2, 0, 1},
+    {"333445", INVALID, 0, 0},
+    {"3333", BOMB, 0, 1},
+    {"2222", BOMB, 12, 1},
+    {"333345", QUADRUPLE2, 0, 1},
+    {"33334455", QUADRUPLE4, 0, 1},  // 带两对
+    {"333344", INVALID, 0, 0},       // 一对不算两张单牌
+    {"3333445", INVALID, 0, 0},
+    {"33334444", SSHUTTLE, 0, 2},
+    {"333444", PLANE, 0, 2},
+    {"AAA222", INVALID, 0, 0},       // 2 不能连
+    {"33344456", PLANE1, 0, 2},
+    {"333444xX", PLANE1, 0, 2},      // 两张王可以当作两张小翼
+    {"3334445566", PLANE2, 0, 2},
+    {"3334445", INVALID, 0, 0},      // 小翼少一张
+    {"333444567", INVALID, 0, 0},    // 小翼多一张
+    {"33344455", INVALID, 0, 0},     // 大翼少一对
+    {"333555", INVALID, 0, 0},
+    {"333444555666", PLANE, 0, 4},
+    {"333344445678", SSHUTTLE2, 0, 2},
+    {"333344445566778", INVALID, 0, 0},
+    {"3333444455667788", SSHUTTLE4, 0, 2},
+};
+
+static void test_classify() {
+    for (const ClassifyCase& c : CLASSIFY_CASES) {
+        CardSet cards = parse_cards(c.cards);
+        Combo combo = classify(cards);
+        string what = string("classify ") + c.cards + " = " + COMBO_NAME[combo.type];
+        expect(combo.type == c.type, what + ", expected " + COMBO_NAME[c.type]);
+        if (c.type != INVALID && combo.type == c.type) {
+            expect(combo.level == c.level && combo.length == c.length, what + " level/length " +
+                   to_string(combo.level) + "/" + to_string(combo.length));
+            expect(combo.size == (int)cards.size(), what + " size");
+        }
+    }
+}
+
+struct BeatsCase {
+    const char* a;
+    const char* b;
+    bool beats;
+};
+
+static const BeatsCase BEATS_CASES[] = {
+    {"4", "3", true},
+    {"3", "4", false},
+    {"3", "3", false},
+    {"X", "x", true},
+    {"44", "33", true},
+    {"45678", "34567", true},
+    {"45678", "345678", false},    // 长度不同
+    {"444555", "333444", true},
+    {"44455", "3334", false},      // 牌型不同
+    {"3333", "2", true},
+    {"3333", "34567", true},
+    {"4444", "3335", true},        // 炸弹压同样四张的三带一
+    {"4445", "3333", false},
+    {"4444", "3333", true},
+    {"3333", "4444", false},
+    {"3333", "44445566", true},    // 炸弹压四带两对
+    {"33334455", "3333", false},
+    {"xX", "22", true},            // 火箭压同样两张的对子
+    {"22", "xX", false},
+    {"xX", "2222", true},
+    {"2222", "xX", false},
+};
+
+static void test_beats() {
+    for (const BeatsCase& c : BEATS_CASES) {
+        bool result = beats(classify(parse_cards(c.a)), classify(parse_cards(c.b)));
+        expect(result == c.beats, string("beats ") + c.a + " over " + c.b);
+    }
+
+    // hand 出 play，上家 / 上上家分别出了 last / before
+    struct { const char* hand; const char* before; const char* last; const char* play; bool legal; } plays[] = {
+        {"3456", "", "", "", false},          // 自由出牌不能过
+        {"3456", "", "", "3", true},
+        {"3456", "", "", "7", false},         // 不在手里
+        {"3456", "", "", "34", false},        // 牌型非法
+        {"3456", "", "2", "", true},
+        {"3456", "", "2", "6", false},
+        {"3456", "5", "", "6", true},         // 上家过，压上上家
+        {"3456", "5", "", "4", false},
+        {"3333", "", "KKKK", "3333", false},
+    };
+    for (const auto& p : plays) {
+        CardSet history[2] = {parse_cards(p.before), parse_cards(p.last)};
+        // 手牌和桌面的牌编号可能重合，这里只看点数，桌面的牌从大花色开始取
+        for (CardSet& h : history) {
+            CardSet shifted;
+            for (short card : h) shifted.insert(card < 52 ? card / 4 * 4 + 3 - card % 4 : card);
+            h = shifted;
+        }
+        Combo combo;
+        const char* reason = check_play(parse_cards(p.hand), history, parse_cards(p.play), combo);
+        expect((reason == nullptr) == p.legal, string("check_play ") + p.hand + " plays '" + p.play + "' after '" +
+               p.before + "','" + p.last + "': " + (reason ? reason : "legal"));
+    }
+}
+
+struct ParseCase {
+    const char* text;
+    bool ok;
+    Response::Kind kind;
+    long long number;
+    const char* error;
+    size_t offset;
+};
+
+static const ParseCase PARSE_CASES[] = {
+    {"{\"response\":2}", true, Response::NUMBER, 2, nullptr, 0},
+    {"  {\"debug\":{\"a\":[1,{}]},\"response\":-1}\n", true, Response::NUMBER, -1, nullptr, 0},
+    {"{\"response\":2.0}", true, Response::NUMBER, 2, nullptr, 0},
+    {"{\"response\":2e0}", true, Response::NUMBER, 2, nullptr, 0},
+    {"{\"response\":2.5}", true, Response::OTHER, 0, nullptr, 0},
+    {"{\"response\":\"2\"}", true, Response::OTHER, 0, nullptr, 0},
+    {"{\"response\":[]}", true, Response::CARDS, 0, nullptr, 0},
+    {"{\"response\":[1,\"a\"]}", true, Response::OTHER, 0, nullptr, 0},
+    {"{\"data\":1}", true, Response::MISSING, 0, nullptr, 0},
+    {"{}", true, Response::MISSING, 0, nullptr, 0},
+    // 顶层对象之后的内容忽略，与 jsoncpp 一致
+    {"{\"response\":1}\ndebug: 42", true, Response::NUMBER, 1, nullptr, 0},
+    {"{\"response\":1}{\"response\":2}", true, Response::NUMBER, 1, nullptr, 0},
+    {"{\"response\":1}\n>>>BOTZONE_REQUEST_KEEP_RUNNING<<<\n", true, Response::NUMBER, 1, nullptr, 0},
+    {"", false, Response::MISSING, 0, "empty output", 0},
+    {"  \n", false, Response::MISSING, 0, "empty output", 3},
+    {"[1]", false, Response::MISSING, 0, "expected '{'", 0},
+    {"{\"response\" 1}", false, Response::MISSING, 0, "expected ':'", 12},
+    {"{\"response\":1 \"x\":2}", false, Response::NUMBER, 1, "expected ',' or '}'", 14},
+    {"{\"response\":1,\"response\":2}", false, Response::NUMBER, 1, "duplicate response", 25},
+    {"{\"response\":[1,2}", false, Response::MISSING, 0, "expected ',' or ']'", 16},
+    {"{\"response\":-}", false, Response::MISSING, 0, "bad number", 13},
+    {"{\"response\":tru}", false, Response::MISSING, 0, "unexpected character", 12},
+    {"{\"a\":\"\\q\"}", false, Response::MISSING, 0, "bad escape", 7},
+    {"{\"a\":\"abc", false, Response::MISSING, 0, "unterminated string", 9},
+    {"{\"response\":1", false, Response::NUMBER, 1, "expected ',' or '}'", 13},
+};
+
+static void test_parser() {
+    for (const ParseCase& c : PARSE_CASES) {
+        Response r;
+        bool ok = ResponseParser::parse(c.text, r);
+        string what = string("parse ") + c.text + ": " + (r.error ? r.error : "ok") + " at " + to_string(r.offset);
+        expect(ok == c.ok, what);
+        if (ok) {
+            expect(r.kind == c.kind, what + " kind");
+            if (c.kind == Response::NUMBER) expect(r.number == c.number, what + " number");
+        }
+        else expect(r.error && string(r.error) == c.error && r.offset == c.offset, what + ", expected " + c.error +
+                    " at " + to_string(c.offset));
+    }
+
+    Response r;
+    expect(ResponseParser::parse("{\"response\":[0,53,17]}", r) && r.kind == Response::CARDS && !r.bad_card &&
+           r.cards.size() == 3 && r.cards.contains(53), "parse cards");
+    r = Response();
+    expect(ResponseParser::parse("{\"response\":[3,3]}", r) && r.bad_card, "parse repeated card");
+    r = Response();
+    expect(ResponseParser::parse("{\"response\":[54]}", r) && r.bad_card, "parse card out of range");
+    r = Response();
+    expect(ResponseParser::parse("{\"response\":[-1]}", r) && r.bad_card, "parse negative card");
+}
+
+// 随机手牌上，for_each_move 生成的每一手都由 classify 认定为同样的牌型且压得过 target，
+// 并且与逐个枚举手牌子集得到的全部合法出法完全一致
+static void test_moves() {
+    std::mt19937_64 rng(20241017);
+    int checked = 0;
+    for (int round = 0; round < 400 && failures < 20; round++) {
+        vector<int> deck(CARD_COUNT);
+        for (int i = 0; i < CARD_COUNT; i++) deck[i] = i;
+        shuffle(deck.begin(), deck.end(), rng);
+        int size = 1 + round % 12;
+        CardSet hand_cards = CardSet::of(deck.begin(), deck.begin() + size);
+        endgame::Counts hand = endgame::counts_of(hand_cards);
+
+        // 要压的牌: 自由出牌，或者从另外几张牌里随机挑一手
+        Combo target{PASS, 0, 0, 0};
+        if (round % 3) {
+            CardSet other = CardSet::of(deck.begin() + size, deck.begin() + size + 8);
+            vector<Combo> options;
+            endgame::for_each_move(endgame::counts_of(other), [&](endgame::Counts, const Combo& c) { options.push_back(c); });
+            if (!options.empty()) target = options[rng() % options.size()];
+        }
+        const Combo* against = target.type == PASS ? nullptr : &target;
+
+        vector<endgame::Counts> generated;
+        endgame::for_each_move(hand, [&](endgame::Counts cards, const Combo& c) {
+            Combo actual = classify(endgame::cards_of(cards));
+            bool same = actual.type == c.type && actual.level == c.level && actual.length == c.length && actual.size == c.size;
+            expect(same, "for_each_move yields " + string(COMBO_NAME[c.type]) + " classified as " + COMBO_NAME[actual.type]);
+            expect(actual.type != INVALID && actual.type != PASS, "for_each_move yields an invalid move");
+            expect(!against || beats(actual, target), "for_each_move yields a move that does not beat the target");
+            expect(endgame::cards_of(hand).includes(endgame::cards_of(cards)), "for_each_move yields cards not in hand");
+            generated.push_back(cards);
+        }, against);
+
+        // 按点数逐个枚举子集
+        vector<endgame::Counts> expected;
+        int counts[LEVEL_COUNT];
+        for (int level = 0; level < LEVEL_COUNT; level++) counts[level] = endgame::count_at(hand, level);
+        int pick[LEVEL_COUNT] = {};
+        for (;;) {
+            int level = 0;
+            while (level < LEVEL_COUNT && pick[level] == counts[level]) pick[level++] = 0;
+            if (level == LEVEL_COUNT) break;
+            pick[level]++;
+            endgame::Counts cards = 0;
+            for (int l = 0; l < LEVEL_COUNT; l++) cards += endgame::unit(l, pick[l]);
+            Combo c = classify(endgame::cards_of(cards));
+            if (c.type != INVALID && (!against || beats(c, target))) expected.push_back(cards);
+        }
+        sort(generated.begin(), generated.end());
+        sort(expected.begin(), expected.end());
+        expect(adjacent_find(generated.begin(), generated.end()) == generated.end(), "for_each_move yields a move twice");
+        generated.erase(unique(generated.begin(), generated.end()), generated.end());
+        expect(generated == expected, "for_each_move on a " + to_string(size) + "-card hand against " + COMBO_NAME[target.type] +
+               ": " + to_string(generated.size()) + " moves, expected " + to_string(expected.size()));
+        checked += (int)expected.size();
+    }
+    expect(checked > 1000, "for_each_move checked too few moves");
+}
+
+int main() {
+    test_classify();
+    test_beats();
+    test_parser();
+    test_moves();
+    if (failures) {
+        cout << failures << " test(s) failed\n";
+        return 1;
+    }
+    cout << "all tests passed\n";
+    return 0;
+}
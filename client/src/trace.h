@@ -0,0 +1,227 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// 分阶段的耗时追踪：每个线程把事件 (阶段、玩家、轮次、起止时刻) 写进自己的环形缓冲区，不加锁；
+// 缓冲区写满后覆盖最早的事件，各阶段的累计耗时另外累加，不受覆盖影响。
+// 结束时导出 Chrome trace JSON (chrome://tracing 或 Perfetto 打开)，并按线程、按 bot 汇总各阶段的耗时。
+// 没有启用时每个追踪点只是一次判断；编译时定义 BATTLEFIELD_NO_TRACE 则追踪点完全去掉。
+// bot 的决策时间在 epoll 调度下会互相重叠，导出为异步事件，其余阶段为同步事件。
+
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <iomanip>
+
+// 写入 JSON 字符串时转义引号、反斜杠和控制字符 (bot 名字和路径可能含有这些字符)
+inline std::string json_escape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        }
+        else if ((unsigned char)c < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            out += code;
+        }
+        else out += c;
+    }
+    return out;
+}
+
+namespace trace {
+
+enum Phase : uint8_t {
+    ROUND_SETUP,  // 发牌、排座
+    LAUNCH,       // 查决策缓存、启动 bot 进程或写入常驻进程
+    BOT,          // bot 思考 (从启动/写入到得到输出)
+    FEED,         // 解析输出、合法性检查、构建下一条请求
+    SETTLE,       // 计分、写对局记录
+    PUBLISH,      // 合并成绩、更新评分、输出排名
+    CHECKPOINT,   // 写检查点
+    ENDGAME,      // 残局分析
+    PHASE_COUNT
+};
+
+inline const char* const PHASE_NAMES[PHASE_COUNT] = {"round_setup", "launch", "bot", "feed", "settle", "publish", "checkpoint", "endgame"};
+
+using Clock = std::chrono::steady_clock;
+
+struct Event {
+    int64_t begin_ns;  // 相对追踪开始的时刻
+    int64_t duration_ns;
+    int32_t game;      // 轮次，-1 表示无关
+    int16_t player;    // 玩家 id，-1 表示无关
+    uint8_t phase;
+    uint8_t async;
+};
+
+class Tracer {
+public:
+    // capacity 为每个线程保留的事件数，player_count 用于按 bot 汇总
+    void start(int player_count, size_t capacity) {
+        players = player_count;
+        ring_size = capacity > 0 ? capacity : 1;
+        origin = Clock::now();
+        on = true;
+    }
+
+    bool enabled() const { return on; }
+
+    void record(Phase phase, int player, int game, Clock::time_point begin, Clock::time_point end, bool async = false) {
+        ThreadBuffer& b = buffer();
+        int64_t from = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - origin).count();
+        int64_t length = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        b.ring[b.next] = {from, length, game, (int16_t)player, phase, (uint8_t)async};
+        if (++b.next == b.ring.size()) {
+            b.next = 0;
+            b.wrapped = true;
+        }
+        b.events++;
+        b.phase_ns[phase] += length;
+        if (player >= 0 && player < players) b.player_ns[(size_t)player * PHASE_COUNT + phase] += length;
+    }
+
+    // 导出 Chrome trace JSON，names 为各玩家的名字；只能在各线程都停止记录之后调用
+    bool write_chrome(const std::string& path, const std::vector<std::string>& names) const {
+        FILE* f = fopen(path.c_str(), "w");
+        if (!f) return false;
+        fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        std::vector<std::string> escaped;
+        for (const std::string& name : names) escaped.push_back(json_escape(name));
+        bool first = true;
+        long long async_id = 0;
+        for (const auto& b : threads) {
+            fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}",
+                    first ? "" : ",\n", b->tid, b->tid);
+            first = false;
+            size_t count = b->wrapped ? b->ring.size() : b->next;
+            size_t start = b->wrapped ? b->next : 0;
+            for (size_t i = 0; i < count; i++) {
+                const Event& e = b->ring[(start + i) % b->ring.size()];
+                // 名字可能很长，不用定长缓冲区，以免截断后 JSON 不完整
+                std::string args = "\"game\":" + std::to_string(e.game);
+                if (e.player >= 0 && e.player < (int)names.size()) args += ",\"bot\":\"" + escaped[e.player] + "\"";
+                const char* name = PHASE_NAMES[e.phase];
+                if (e.async) {
+                    // 异步事件按 id 配对，Perfetto 为每个重叠的事件单独开一行
+                    fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"bot\",\"ph\":\"b\",\"id\":%lld,\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{%s}}"
+                               ",\n{\"name\":\"%s\",\"cat\":\"bot\",\"ph\":\"e\",\"id\":%lld,\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+                            name, async_id, b->tid, e.begin_ns / 1e3, args.c_str(),
+                            name, async_id, b->tid, (e.begin_ns + e.duration_ns) / 1e3);
+                    async_id++;
+                }
+                else
+                    fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"engine\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{%s}}",
+                            name, b->tid, e.begin_ns / 1e3, e.duration_ns / 1e3, args.c_str());
+            }
+        }
+        fprintf(f, "\n]}\n");
+        return fclose(f) == 0;
+    }
+
+    // 各阶段的累计耗时 (毫秒)，按线程和按 bot
+    void print_summary(std::ostream& out, const std::vector<std::string>& names) const {
+        long long events = 0, kept = 0;
+        for (const auto& b : threads) {
+            events += b->events;
+            kept += b->wrapped ? b->ring.size() : b->next;
+        }
+        out << "Trace: " << events << " events, " << kept << " kept\n" << std::fixed << std::setprecision(1);
+        for (const auto& b : threads) {
+            out << "  thread " << b->tid << ":";
+            for (int p = 0; p < PHASE_COUNT; p++)
+                if (b->phase_ns[p]) out << " " << PHASE_NAMES[p] << " " << b->phase_ns[p] / 1e6 << " ms";
+            out << "\n";
+        }
+        for (int i = 0; i < players; i++) {
+            long long sum[PHASE_COUNT] = {};
+            bool any = false;
+            for (const auto& b : threads)
+                for (int p = 0; p < PHASE_COUNT; p++) {
+                    sum[p] += b->player_ns[(size_t)i * PHASE_COUNT + p];
+                    any |= sum[p] != 0;
+                }
+            if (!any) continue;
+            out << "  " << (i < (int)names.size() ? names[i] : std::to_string(i)) << ":";
+            for (int p = 0; p < PHASE_COUNT; p++)
+                if (sum[p]) out << " " << PHASE_NAMES[p] << " " << sum[p] / 1e6 << " ms";
+            out << "\n";
+        }
+        out << std::defaultfloat;
+    }
+
+private:
+    struct ThreadBuffer {
+        int tid = 0;
+        std::vector<Event> ring;
+        size_t next = 0;
+        bool wrapped = false;
+        long long events = 0;
+        long long phase_ns[PHASE_COUNT] = {};
+        std::vector<long long> player_ns;  // [player][phase]
+    };
+    bool on = false;
+    int players = 0;
+    size_t ring_size = 0;
+    Clock::time_point origin;
+    std::mutex lock;  // 只在线程第一次记录时使用
+    std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+    ThreadBuffer& buffer() {
+        thread_local ThreadBuffer* mine = nullptr;
+        if (!mine) {
+            std::lock_guard<std::mutex> guard(lock);
+            threads.push_back(std::make_unique<ThreadBuffer>());
+            mine = threads.back().get();
+            mine->tid = threads.size() - 1;
+            mine->ring.resize(ring_size);
+            mine->player_ns.assign((size_t)players * PHASE_COUNT, 0);
+        }
+        return *mine;
+    }
+};
+
+inline Tracer tracer;
+
+#ifndef BATTLEFIELD_NO_TRACE
+// 作用域内的一段同步耗时
+class Scope {
+public:
+    explicit Scope(Phase phase, int player = -1, int game = -1) : phase(phase), player(player), game(game) {
+        if (tracer.enabled()) begin = Clock::now();
+    }
+    ~Scope() {
+        if (tracer.enabled()) tracer.record(phase, player, game, begin, Clock::now());
+    }
+
+private:
+    Phase phase;
+    int player, game;
+    Clock::time_point begin;
+};
+
+// 已知时长的一段耗时，到现在为止的 duration_ms
+inline void elapsed(Phase phase, int player, int game, double duration_ms, bool async) {
+    if (!tracer.enabled()) return;
+    Clock::time_point end = Clock::now();
+    tracer.record(phase, player, game, end - std::chrono::nanoseconds((long long)(duration_ms * 1e6)), end, async);
+}
+#else
+class Scope {
+public:
+    explicit Scope(Phase, int = -1, int = -1) {}
+};
+inline void elapsed(Phase, int, int, double, bool) {}
+#endif
+
+} // namespace trace
+
+#endif // TRACE_H
@@ -0,0 +1,147 @@
+#ifndef TRANSCRIPT_H
+#define TRANSCRIPT_H
+
+// 每个座位本局的交互记录，直接维护 bot 的完整输入：
+//   {"requests":[r0,r1,...]<空格>],"responses":[p0,p1,...]}
+// requests 之后留一段空格作为间隙，新请求写进间隙，新回应追加在末尾，
+// 整个输入始终是一段连续的合法 JSON (以 '\0' 结尾)，每一步只写入新增的字节。
+// 缓冲区从所属桌的 Arena 中分配，每局开始时整体回收。
+
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <charconv>
+#include <memory>
+#include <vector>
+#include <string_view>
+
+// 按块分配的内存池：只分配不释放，reset() 时回收全部内存
+// 一局用到多个块时，reset() 把它们合并成一个足够大的块，之后的对局不再申请内存
+class Arena {
+public:
+    char* alloc(size_t n) {
+        if (used + n > size) {
+            if (head) retired.push_back(std::move(head));
+            total += size;
+            size = std::max({n, 2 * size, (size_t)4096});
+            head.reset(new char[size]);
+            used = 0;
+        }
+        char* p = head.get() + used;
+        used += n;
+        return p;
+    }
+
+    void reset() {
+        if (!retired.empty()) {
+            retired.clear();
+            size += total;
+            head.reset(new char[size]);
+        }
+        total = 0;
+        used = 0;
+    }
+
+private:
+    std::unique_ptr<char[]> head;
+    std::vector<std::unique_ptr<char[]>> retired;
+    size_t size = 0, used = 0;
+    size_t total = 0;  // retired 中各块的大小之和
+};
+
+class Transcript {
+public:
+    void reset(Arena* a) {
+        arena = a;
+        buf = nullptr;
+        cap = 0;
+        count = 0;
+        req_end = last_begin = resp_begin = resp_end = 0;
+        grow(REQ_HEAD.size() + 64, RESP_TAIL.size() + 64);
+        memcpy(buf, REQ_HEAD.data(), REQ_HEAD.size());
+        req_end = REQ_HEAD.size();
+        memcpy(buf + resp_begin, RESP_TAIL.data(), RESP_TAIL.size());
+        resp_end = resp_begin + RESP_TAIL.size();
+        buf[resp_end] = '\0';
+        first_response = true;
+    }
+
+    // 已经收到的请求数
+    size_t requests() const { return count; }
+
+    // 完整输入，也可以当作以 '\0' 结尾的 C 字符串使用
+    std::string_view input() const { return std::string_view(buf, resp_end); }
+
+    // 最新的一条请求
+    std::string_view last_request() const { return std::string_view(buf + last_begin, req_end - last_begin); }
+
+    // 新请求: begin_request(); put(...); ...
+    void begin_request() {
+        writing_response = false;
+        if (count++) put(",", 1);
+        last_begin = req_end;
+    }
+
+    // 新回应: begin_response(); put(...); ...
+    void begin_response() {
+        writing_response = true;
+        if (!first_response) put(",", 1);
+        first_response = false;
+    }
+
+    void put(const char* s, size_t n) {
+        if (!writing_response) {
+            if (resp_begin - req_end < n) grow(n, 0);
+            memcpy(buf + req_end, s, n);
+            req_end += n;
+        }
+        else {
+            // 覆盖末尾的 "]}" 后重新补上
+            if (cap - resp_end - 1 < n) grow(0, n);
+            memcpy(buf + resp_end - 2, s, n);
+            resp_end += n;
+            memcpy(buf + resp_end - 2, "]}", 3);
+        }
+    }
+    void put(std::string_view s) { put(s.data(), s.size()); }
+    void put(int v) {
+        char num[12];
+        char* end = std::to_chars(num, num + sizeof(num), v).ptr;
+        put(num, end - num);
+    }
+
+private:
+    static constexpr std::string_view REQ_HEAD = "{\"requests\":[";
+    static constexpr std::string_view RESP_TAIL = "],\"responses\":[]}";
+
+    Arena* arena = nullptr;
+    char* buf = nullptr;
+    size_t cap = 0;
+    size_t count = 0;
+    size_t req_end = 0, last_begin = 0;  // requests 部分的结尾，最新请求的开头
+    size_t resp_begin = 0, resp_end = 0; // responses 部分 (含 "]," 前缀) 的范围
+    bool writing_response = false;
+    bool first_response = true;
+
+    // 换一块更大的缓冲区，保证间隙至少 gap 字节、末尾至少 tail 字节；
+    // 容量翻倍增长，搬移的总量与最终长度成线性
+    void grow(size_t gap, size_t tail) {
+        size_t resp_len = resp_end - resp_begin;
+        size_t used = req_end + resp_len + 1;
+        size_t new_cap = std::max(2 * cap, 2 * (used + gap + tail));
+        char* next = arena->alloc(new_cap);
+        size_t free = new_cap - used;
+        size_t new_gap = std::max(gap, free / 2);
+        memset(next + req_end, ' ', new_gap);
+        if (buf) {
+            memcpy(next, buf, req_end);
+            memcpy(next + req_end + new_gap, buf + resp_begin, resp_len + 1);
+        }
+        buf = next;
+        cap = new_cap;
+        resp_begin = req_end + new_gap;
+        resp_end = resp_begin + resp_len;
+    }
+};
+
+#endif // TRANSCRIPT_H
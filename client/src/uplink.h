@@ -0,0 +1,319 @@
+#ifndef UPLINK_H
+#define UPLINK_H
+
+// 引擎直接连接后端的 WebSocket 上行通道，代替 stdout → bridge → 后端的转发。
+// 发布线程把消息压入无锁队列 (只有一次 CAS，不做系统调用)，专门的 I/O 线程每隔 interval_ms 取走全部消息：
+// 同一批里的快照消息 (rank_update / partial，后一条完整覆盖前一条) 只发最后一条，其余按顺序发送，
+// 一批的帧拼在一起用一次 send 写出。断线后每隔几秒重连，重连后先补发 init，再发最新的快照。
+// 只支持 ws:// (不支持 TLS)；握手只检查状态码 101。
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+class Uplink {
+public:
+    Uplink() = default;
+    Uplink(const Uplink&) = delete;
+    Uplink& operator=(const Uplink&) = delete;
+    ~Uplink() { close(); }
+
+    // 连接 url (ws://host[:port][/path][?query])，第一次连接失败时返回 false，由调用方改用 stdout
+    bool start(const std::string& url, int interval_ms) {
+        if (!parse_url(url)) return fail("only ws:// urls are supported");
+#ifdef _WIN32
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return fail("cannot initialize winsock");
+#endif
+        interval = std::chrono::milliseconds(interval_ms > 0 ? interval_ms : 1);
+        if (!connect_socket()) return false;
+        closing = false;
+        worker = std::thread([this] { run(); });
+        return true;
+    }
+
+    bool running() const { return worker.joinable(); }
+    const std::string& error() const { return message; }
+
+    // 压入一条消息 (JSON 文本)；snapshot 表示这条完整覆盖之前同类的消息，积压时只发最新的一条；
+    // resend 表示重连后需要重新发送 (init)
+    void send(std::string text, bool snapshot = false, bool resend = false) {
+        Node* node = new Node{std::move(text), snapshot, resend, nullptr};
+        node->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    // 发送完队列里的消息后关闭连接
+    void close() {
+        if (worker.joinable()) {
+            closing = true;
+            worker.join();
+        }
+        for (Node* node = head.exchange(nullptr); node;) {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+        disconnect();
+    }
+
+    // 实际发出的消息数和因合并而丢弃的快照数
+    long long sent() const { return sent_count; }
+    long long coalesced() const { return coalesced_count; }
+
+private:
+    struct Node {
+        std::string text;
+        bool snapshot, resend;
+        Node* next;
+    };
+#ifdef _WIN32
+    using Socket = SOCKET;
+    static constexpr Socket NO_SOCKET = INVALID_SOCKET;
+#else
+    using Socket = int;
+    static constexpr Socket NO_SOCKET = -1;
+#endif
+
+    std::string host, port, path;
+    std::chrono::milliseconds interval{100};
+    Socket sock = NO_SOCKET;
+    std::atomic<Node*> head{nullptr};  // 后进先出，I/O 线程取走后反转
+    std::atomic<bool> closing{false};
+    std::thread worker;
+    std::string message;
+    std::mt19937 mask_rng{std::random_device{}()};
+    std::string resend_text;  // 最近一条需要重发的消息
+    std::string snapshot_text;  // 断线期间积压的最新快照
+    std::string out;   // 一批待写出的帧
+    std::string in;    // 未处理完的输入
+    long long sent_count = 0, coalesced_count = 0;
+
+    bool fail(const char* reason) {
+        message = reason;
+        return false;
+    }
+
+    bool parse_url(const std::string& url) {
+        if (url.compare(0, 5, "ws://") != 0) return false;
+        size_t slash = url.find_first_of("/?", 5);
+        std::string authority = url.substr(5, slash == std::string::npos ? std::string::npos : slash - 5);
+        path = slash == std::string::npos ? "/" : url.substr(slash);
+        if (path[0] == '?') path = "/" + path;
+        size_t colon = authority.rfind(':');
+        host = colon == std::string::npos ? authority : authority.substr(0, colon);
+        port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+        return !host.empty();
+    }
+
+    void disconnect() {
+        if (sock == NO_SOCKET) return;
+#ifdef _WIN32
+        closesocket(sock);
+#else
+        ::close(sock);
+#endif
+        sock = NO_SOCKET;
+        in.clear();
+    }
+
+    bool write_all(const char* data, size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            int n = ::send(sock, data, (int)size, 0);
+#else
+            ssize_t n = ::send(sock, data, size, MSG_NOSIGNAL);
+#endif
+            if (n <= 0) return false;
+            data += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    // TCP 连接和 WebSocket 握手
+    bool connect_socket() {
+        addrinfo hints = {}, *result = nullptr;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) return fail("cannot resolve host");
+        for (addrinfo* a = result; a && sock == NO_SOCKET; a = a->ai_next) {
+            sock = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (sock == NO_SOCKET) continue;
+            if (connect(sock, a->ai_addr, (int)a->ai_addrlen) != 0) disconnect();
+        }
+        freeaddrinfo(result);
+        if (sock == NO_SOCKET) return fail("cannot connect");
+        int one = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+
+        static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string key;
+        for (int i = 0; i < 22; i++) key += BASE64[mask_rng() & 63];
+        key[21] = BASE64[mask_rng() & 48];  // 16 字节的 base64，最后一个字符只用高 2 位
+        key += "==";
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + host + ":" + port +
+                              "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: " + key +
+                              "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+        if (!write_all(request.data(), request.size())) return handshake_failed();
+        std::string response;
+        char buf[1024];
+        size_t end;
+        while ((end = response.find("\r\n\r\n")) == std::string::npos) {
+            int n = recv(sock, buf, sizeof(buf), 0);
+            if (n <= 0 || response.size() > 16384) return handshake_failed();
+            response.append(buf, n);
+        }
+        if (response.compare(0, 12, "HTTP/1.1 101") != 0) return handshake_failed();
+        in = response.substr(end + 4);
+        return true;
+    }
+
+    bool handshake_failed() {
+        disconnect();
+        return fail("websocket handshake failed");
+    }
+
+    // 客户端发出的帧必须加掩码
+    void append_frame(int opcode, const char* data, size_t size) {
+        out += (char)(0x80 | opcode);
+        if (size < 126) out += (char)(0x80 | size);
+        else if (size < 65536) {
+            out += (char)(0x80 | 126);
+            for (int shift = 8; shift >= 0; shift -= 8) out += (char)(size >> shift);
+        }
+        else {
+            out += (char)(0x80 | 127);
+            for (int shift = 56; shift >= 0; shift -= 8) out += (char)((uint64_t)size >> shift);
+        }
+        uint32_t mask = mask_rng();
+        char key[4];
+        memcpy(key, &mask, 4);
+        out.append(key, 4);
+        size_t at = out.size();
+        out.append(data, size);
+        for (size_t i = 0; i < size; i++) out[at + i] ^= key[i & 3];
+    }
+
+    // 处理后端发来的帧：回应 ping，收到 close 时断开，其余忽略；连接出错返回 false
+    bool poll_input() {
+        char buf[4096];
+        for (;;) {
+#ifdef _WIN32
+            u_long pending = 0;
+            if (ioctlsocket(sock, FIONREAD, &pending) != 0) return false;
+            if (pending == 0) break;
+#else
+            pollfd p = {sock, POLLIN, 0};
+            if (poll(&p, 1, 0) <= 0) break;
+#endif
+            int n = recv(sock, buf, sizeof(buf), 0);
+            if (n <= 0) return false;
+            in.append(buf, n);
+        }
+        while (in.size() >= 2) {
+            int opcode = in[0] & 0x0F;
+            uint64_t size = in[1] & 0x7F;
+            size_t header = 2;
+            if (size == 126 || size == 127) {
+                int bytes = size == 126 ? 2 : 8;
+                if (in.size() < 2 + (size_t)bytes) break;
+                size = 0;
+                for (int i = 0; i < bytes; i++) size = size << 8 | (uint8_t)in[2 + i];
+                header += bytes;
+            }
+            bool masked = in[1] & 0x80;  // 服务器不应加掩码，照样处理
+            if (masked) header += 4;
+            if (in.size() < header || in.size() - header < size) break;
+            if (opcode == 0x8) return false;
+            if (opcode == 0x9) {
+                if (masked)
+                    for (size_t i = 0; i < size; i++) in[header + i] ^= in[header - 4 + (i & 3)];
+                append_frame(0xA, in.data() + header, size);
+            }
+            in.erase(0, header + size);
+        }
+        return true;
+    }
+
+    void run() {
+        auto retry_at = std::chrono::steady_clock::now();
+        for (bool last = false; !last;) {
+            last = closing.load();
+            if (!last) std::this_thread::sleep_for(interval);
+
+            // 取走队列，反转成先进先出的顺序，同一批的快照只保留最后一条
+            Node* list = nullptr;
+            for (Node* node = head.exchange(nullptr, std::memory_order_acquire); node;) {
+                Node* next = node->next;
+                node->next = list;
+                list = node;
+                node = next;
+            }
+            Node* latest = nullptr;
+            for (Node* node = list; node; node = node->next)
+                if (node->snapshot) latest = node;
+            if (latest && !snapshot_text.empty()) coalesced_count++;
+            if (latest) snapshot_text.clear();
+
+            bool online = sock != NO_SOCKET && poll_input();
+            if (!online && sock != NO_SOCKET) disconnect();
+            // 只在真正尝试连接失败后推迟下一次重连
+            auto now = std::chrono::steady_clock::now();
+            if (!online && now >= retry_at) {
+                if (connect_socket()) {
+                    online = true;
+                    if (!resend_text.empty()) append_frame(0x1, resend_text.data(), resend_text.size());
+                }
+                else retry_at = now + std::chrono::seconds(3);
+            }
+            if (online && !snapshot_text.empty()) {
+                append_frame(0x1, snapshot_text.data(), snapshot_text.size());
+                snapshot_text.clear();
+                sent_count++;
+            }
+
+            while (list) {
+                Node* node = list;
+                list = node->next;
+                if (node->resend) resend_text = node->text;
+                if (node->snapshot && node != latest) coalesced_count++;
+                else if (!online) {
+                    if (node->snapshot) snapshot_text = std::move(node->text);
+                }
+                else {
+                    append_frame(0x1, node->text.data(), node->text.size());
+                    sent_count++;
+                }
+                delete node;
+            }
+            if (online && !out.empty() && !write_all(out.data(), out.size())) disconnect();
+            out.clear();
+        }
+        if (sock != NO_SOCKET) {
+            static const char NORMAL_CLOSURE[2] = {0x03, (char)0xE8};  // 1000
+            append_frame(0x8, NORMAL_CLOSURE, 2);
+            write_all(out.data(), out.size());
+            out.clear();
+        }
+    }
+};
+
+#endif // UPLINK_H